@@ -0,0 +1,63 @@
+#include "alloc_counter.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+void* Allocate(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size ? size : 1);
+}
+
+void* AllocateAligned(size_t size, std::align_val_t align) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  const size_t alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  const size_t rounded = ((size ? size : 1) + alignment - 1) / alignment * alignment;
+  return aligned_alloc(alignment, rounded);
+}
+
+void* OrAbort(void* p) {
+  if (p == nullptr) abort();  // built with -fno-exceptions: no bad_alloc
+  return p;
+}
+
+}  // namespace
+
+uint64_t AllocationCount() { return g_allocations.load(std::memory_order_relaxed); }
+
+void* operator new(size_t size) { return OrAbort(Allocate(size)); }
+void* operator new[](size_t size) { return OrAbort(Allocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t align) {
+  return OrAbort(AllocateAligned(size, align));
+}
+void* operator new[](size_t size, std::align_val_t align) {
+  return OrAbort(AllocateAligned(size, align));
+}
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, align);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { free(p); }
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// Heap allocations made through any form of operator new since the process
+// started, for benchmarks to diff around a measured region. Only linked into
+// the bench, which gets every standard operator new/delete replaced by
+// counting versions on malloc/free; they live in their own translation unit
+// so the compiler never sees a new paired with a free.
+uint64_t AllocationCount();
@@ -0,0 +1,590 @@
+// Benchmarks for the render path, run with `make bench`. Everything runs
+// offscreen against a corpus of WebPs generated at startup, so the numbers
+// can be compared across machines and releases:
+//
+//  - decode: demux, decode and colour-convert a whole payload, as the decode
+//    stage does, per frame of the payload
+//  - write: put each decoded frame on the display and swap
+//  - transitions: draw, write and swap each frame of every built-in type
+//  - kernels: every colour and blend kernel the CPU supports, checked
+//    against the scalar reference first
+//
+// It also checks that a reopened disk cache sees the last Store. Exits
+// non-zero if that or any kernel check fails.
+//
+// `tronberry_bench --soak [hours]` instead plays hours (default 6) of
+// rotation through the render stage on simulated time, which takes seconds,
+// and checks that every frame, transition and deadline came out exactly as
+// the rotation prescribes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <webp/decode.h>
+#include <webp/demux.h>
+#include <webp/encode.h>
+#include <webp/mux.h>
+
+#include "alloc_counter.h"
+#include "blend_kernels.h"
+#include "color.h"
+#include "color_kernels.h"
+#include "content_cache.h"
+#include "disk_cache.h"
+#include "display.h"
+#include "fetcher.h"
+#include "frame_cache.h"
+#include "pipeline.h"
+#include "render.h"
+#include "time_source.h"
+#include "transitions.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Each measurement repeats until it has run this long, and at least
+// kMinRuns times.
+constexpr auto kMinTime = std::chrono::milliseconds(300);
+constexpr int kMinRuns = 3;
+
+// Transitions benchmarked on top of the built-ins.
+constexpr const char* kBenchTransitions = R"([
+  {"name": "OrbitDots", "type": "orbit", "frame_ms": 22, "frames": 72, "dots": 4},
+  {"name": "Pulse", "type": "pulse", "frames": 24, "min_cycles": 2, "fade": 6},
+  {"name": "Wipe", "type": "wipe", "direction": "diagonal", "frames": 40},
+  {"name": "Dissolve", "type": "dissolve", "frames": 40},
+  {"name": "Swarm", "type": "orbit", "frames": 72, "dots": 400, "rings": 5},
+  {"name": "Crossfade", "type": "crossfade", "frames": 30},
+  {"name": "BlendWipe", "type": "wipe", "direction": "left", "blend": true, "fade": 8,
+   "frames": 30},
+  {"name": "BlendDissolve", "type": "dissolve", "blend": true, "frames": 30}
+])";
+
+struct Samples {
+  std::vector<double> ns;  // per frame
+  double total_ns = 0;
+  uint64_t frames = 0;
+  uint64_t allocations = 0;
+
+  void Add(double frame_ns, uint64_t count = 1) {
+    for (uint64_t i = 0; i < count; ++i) ns.push_back(frame_ns / count);
+    total_ns += frame_ns;
+    frames += count;
+  }
+};
+
+double Percentile(std::vector<double> ns, double p) {
+  if (ns.empty()) return 0;
+  std::sort(ns.begin(), ns.end());
+  return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))];
+}
+
+void PrintHeader(const char* title) {
+  printf("\n%-14s %-22s %10s %9s %11s %9s %9s\n", title, "case", "frames/s", "ns/pixel",
+         "allocs/frm", "p50 us", "p99 us");
+}
+
+void PrintRow(const char* stage, const std::string& name, int pixels, const Samples& s) {
+  const double per_frame = s.total_ns / std::max<uint64_t>(s.frames, 1);
+  printf("%-14s %-22s %10.0f %9.2f %11.2f %9.1f %9.1f\n", stage, name.c_str(),
+         1e9 / per_frame, per_frame / pixels,
+         static_cast<double>(s.allocations) / std::max<uint64_t>(s.frames, 1),
+         Percentile(s.ns, 0.50) / 1000, Percentile(s.ns, 0.99) / 1000);
+}
+
+double Nanos(Clock::time_point from, Clock::time_point to) {
+  return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+// Repeats |run| (which adds its own samples) until enough time has passed,
+// counting the allocations it makes.
+template <typename Fn>
+Samples Measure(Fn run) {
+  Samples samples;
+  run(&samples);  // warm up caches and buffers
+  samples = Samples();
+  const uint64_t before = AllocationCount();
+  const Clock::time_point start = Clock::now();
+  for (int runs = 0; runs < kMinRuns || Clock::now() - start < kMinTime; ++runs) {
+    run(&samples);
+  }
+  samples.allocations = AllocationCount() - before;
+  return samples;
+}
+
+// --- Corpus ---------------------------------------------------------------
+
+struct CorpusItem {
+  std::string name;
+  int width;
+  int height;
+  int frames;
+  std::vector<uint8_t> webp;
+};
+
+// A gradient that drifts from frame to frame with a square moving across
+// it; with |alpha|, only a soft-edged disc around the square is opaque.
+void DrawFrame(int width, int height, int frame, bool alpha, uint8_t* rgba) {
+  const int sx = frame * 3 % width;
+  const int sy = frame * 2 % height;
+  const int size = std::max(height / 4, 4);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x, rgba += 4) {
+      const bool square = x >= sx && x < sx + size && y >= sy && y < sy + size;
+      rgba[0] = square ? 255 : (x * 255 / width + frame * 8) & 255;
+      rgba[1] = square ? 255 : (y * 255 / height + frame * 4) & 255;
+      rgba[2] = square ? 64 : ((x + y) * 4 + frame * 16) & 255;
+      rgba[3] = 255;
+      if (alpha) {
+        const int dx = x - (sx + size / 2);
+        const int dy = y - (sy + size / 2);
+        const int d = dx * dx + dy * dy - size * size;
+        rgba[3] = d <= 0 ? 255 : d >= 255 ? 0 : 255 - d;
+      }
+    }
+  }
+}
+
+bool EncodeStill(int width, int height, bool alpha, std::vector<uint8_t>* webp) {
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  DrawFrame(width, height, 0, alpha, rgba.data());
+  uint8_t* out = nullptr;
+  size_t size = WebPEncodeRGBA(rgba.data(), width, height, width * 4, 80, &out);
+  if (size == 0) return false;
+  webp->assign(out, out + size);
+  WebPFree(out);
+  return true;
+}
+
+bool EncodeAnimation(int width, int height, int frames, bool alpha,
+                     std::vector<uint8_t>* webp) {
+  WebPAnimEncoderOptions options;
+  WebPConfig config;
+  WebPPicture picture;
+  if (!WebPAnimEncoderOptionsInit(&options) || !WebPConfigInit(&config) ||
+      !WebPPictureInit(&picture)) {
+    return false;
+  }
+  config.quality = 80;
+  picture.use_argb = 1;
+  picture.width = width;
+  picture.height = height;
+
+  WebPAnimEncoder* encoder = WebPAnimEncoderNew(width, height, &options);
+  if (encoder == nullptr) return false;
+  std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+  bool ok = true;
+  int timestamp = 0;
+  for (int f = 0; f < frames && ok; ++f, timestamp += 50) {
+    DrawFrame(width, height, f, alpha, rgba.data());
+    ok = WebPPictureImportRGBA(&picture, rgba.data(), width * 4) &&
+         WebPAnimEncoderAdd(encoder, &picture, timestamp, &config);
+  }
+  WebPData data;
+  WebPDataInit(&data);
+  ok = ok && WebPAnimEncoderAdd(encoder, nullptr, timestamp, nullptr) &&
+       WebPAnimEncoderAssemble(encoder, &data);
+  if (ok) webp->assign(data.bytes, data.bytes + data.size);
+  WebPDataClear(&data);
+  WebPPictureFree(&picture);
+  WebPAnimEncoderDelete(encoder);
+  return ok;
+}
+
+std::vector<CorpusItem> BuildCorpus() {
+  struct Kind {
+    const char* name;
+    int frames;
+    bool alpha;
+  };
+  const Kind kinds[] = {
+      {"still", 1, false},
+      {"still-alpha", 1, true},
+      {"anim-10", 10, false},
+      {"anim-60-alpha", 60, true},
+  };
+  const int sizes[][2] = {{64, 32}, {64, 64}, {128, 64}};
+
+  std::vector<CorpusItem> corpus;
+  for (const auto& size : sizes) {
+    for (const Kind& kind : kinds) {
+      CorpusItem item;
+      item.width = size[0];
+      item.height = size[1];
+      item.frames = kind.frames;
+      item.name = std::to_string(size[0]) + "x" + std::to_string(size[1]) + " " + kind.name;
+      bool ok = kind.frames == 1
+                    ? EncodeStill(item.width, item.height, kind.alpha, &item.webp)
+                    : EncodeAnimation(item.width, item.height, kind.frames, kind.alpha,
+                                      &item.webp);
+      if (!ok) {
+        fprintf(stderr, "Failed to encode %s\n", item.name.c_str());
+        continue;
+      }
+      corpus.push_back(std::move(item));
+    }
+  }
+  return corpus;
+}
+
+// --- Pipeline ---------------------------------------------------------------
+
+bool Decode(const CorpusItem& item, const ColorPipeline& color, FrameCache* frames) {
+  WebPData data = {item.webp.data(), item.webp.size()};
+  if (item.frames == 1) return DecodeStill(data, 10000, frames);
+  return DecodeAnimation(data, color, frames);
+}
+
+void BenchPipeline(const std::vector<CorpusItem>& corpus, const ColorPipeline& color) {
+  PrintHeader("pipeline");
+  for (const CorpusItem& item : corpus) {
+    const int pixels = item.width * item.height;
+    FrameCache frames;
+    Samples decode = Measure([&](Samples* s) {
+      Clock::time_point start = Clock::now();
+      Decode(item, color, &frames);
+      s->Add(Nanos(start, Clock::now()), frames.frame_count());
+    });
+    PrintRow("decode", item.name, pixels, decode);
+
+    OffscreenSink display(item.width, item.height);
+    Samples write = Measure([&](Samples* s) {
+      for (size_t i = 0; i < frames.frame_count(); ++i) {
+        Clock::time_point start = Clock::now();
+        display.Blit(0, 0, frames.width, frames.height, frames.frame(i), frames.width * 3);
+        display.Swap();
+        s->Add(Nanos(start, Clock::now()));
+      }
+    });
+    PrintRow("write", item.name, pixels, write);
+  }
+}
+
+void BenchTransitions() {
+  PrintHeader("transitions");
+  const int sizes[][2] = {{64, 32}, {64, 64}, {128, 64}};
+  std::mt19937 rng(1);
+  for (const auto& size : sizes) {
+    const int width = size[0];
+    const int height = size[1];
+    TransitionEngine engine;
+    engine.LoadText(kBenchTransitions, "bench transitions", width, height);
+    TransitionEnds ends;
+    ends.from.Resize(width, height);
+    ends.to.Resize(width, height);
+    for (uint8_t& b : ends.from.pixels) b = rng();
+    for (uint8_t& b : ends.to.pixels) b = rng();
+    RgbFrame image;
+    image.Resize(width, height);
+    OffscreenSink display(width, height);
+
+    for (const auto& t : engine.transitions()) {
+      t->Begin();
+      const int frames = std::max(t->frames_per_cycle * 2, 60);
+      Samples s = Measure([&](Samples* samples) {
+        for (int f = 0; f < frames; ++f) {
+          Clock::time_point start = Clock::now();
+          t->Draw(f, ends, &image);
+          BlitFrame(&display, image);
+          display.Swap();
+          samples->Add(Nanos(start, Clock::now()));
+        }
+      });
+      PrintRow("transition", std::to_string(width) + "x" + std::to_string(height) + " " +
+                                 t->name, width * height, s);
+    }
+  }
+}
+
+// --- Kernels ---------------------------------------------------------------
+
+// Per pixel (or per byte for blends) cost of |run| over |count| units.
+template <typename Fn>
+double KernelNanos(int count, Fn run) {
+  run();
+  int runs = 0;
+  Clock::time_point start = Clock::now();
+  while (runs < 100 || Clock::now() - start < kMinTime / 3) {
+    run();
+    ++runs;
+  }
+  return Nanos(start, Clock::now()) / runs / count;
+}
+
+bool BenchKernels(const ColorPipeline& color) {
+  constexpr int kPixels = 128 * 64;
+  std::mt19937 rng(2);
+  bool ok = true;
+
+  printf("\n%-14s %-22s %9s %s\n", "kernels", "case", "ns/unit", "vs scalar");
+  std::vector<uint8_t> rgba(kPixels * 4);
+  for (size_t i = 0; i < rgba.size(); ++i) {
+    rgba[i] = rng();
+    // Plenty of fully transparent and fully opaque pixels too.
+    if (i % 4 == 3 && i % 12 != 3) rgba[i] = i % 8 == 3 ? 0 : 255;
+  }
+  const RowKernel* rows;
+  const int row_count = AvailableRowKernels(&rows);
+  std::vector<uint8_t> expected(kPixels * 3), got(kPixels * 3);
+  const uint8_t* gamma = color.gamma_table();
+  const int threshold = color.params().black_threshold;
+  rows[0].fn(gamma, threshold, rgba.data(), expected.data(), kPixels);
+  for (int k = 0; k < row_count; ++k) {
+    // Odd lengths exercise the scalar tails of the vector kernels.
+    bool same = true;
+    for (int count : {kPixels, kPixels - 7, 13}) {
+      std::fill(got.begin(), got.end(), 0);
+      rows[k].fn(gamma, threshold, rgba.data(), got.data(), count);
+      same = same && memcmp(got.data(), expected.data(), count * 3) == 0;
+    }
+    double ns = KernelNanos(kPixels, [&] {
+      rows[k].fn(gamma, threshold, rgba.data(), got.data(), kPixels);
+    });
+    printf("%-14s %-22s %9.3f %s\n", "convert", rows[k].name, ns, same ? "ok" : "MISMATCH");
+    ok = ok && same;
+  }
+
+  constexpr int kBytes = kPixels * 3;
+  std::vector<uint8_t> from(kBytes), to(kBytes);
+  std::vector<uint16_t> key(kBytes);
+  for (int i = 0; i < kBytes; ++i) {
+    from[i] = rng();
+    to[i] = rng();
+    key[i] = rng();
+  }
+  const BlendKernel* blends;
+  const int blend_count = AvailableBlendKernels(&blends);
+  std::vector<uint8_t> blend_expected(kBytes), blend_got(kBytes);
+  for (int k = 0; k < blend_count; ++k) {
+    bool same = true;
+    for (int weight : {0, 1, 128, 254, 255}) {
+      blends[0].crossfade(from.data(), to.data(), blend_expected.data(), kBytes - 5, weight);
+      blends[k].crossfade(from.data(), to.data(), blend_got.data(), kBytes - 5, weight);
+      same = same && memcmp(blend_got.data(), blend_expected.data(), kBytes - 5) == 0;
+    }
+    for (int front : {0, 255, 30000, 65535}) {
+      blends[0].keyed(from.data(), to.data(), key.data(), blend_expected.data(), kBytes - 5,
+                      front);
+      blends[k].keyed(from.data(), to.data(), key.data(), blend_got.data(), kBytes - 5, front);
+      same = same && memcmp(blend_got.data(), blend_expected.data(), kBytes - 5) == 0;
+    }
+    double crossfade = KernelNanos(kBytes, [&] {
+      blends[k].crossfade(from.data(), to.data(), blend_got.data(), kBytes, 100);
+    });
+    double keyed = KernelNanos(kBytes, [&] {
+      blends[k].keyed(from.data(), to.data(), key.data(), blend_got.data(), kBytes, 30000);
+    });
+    const char* verdict = same ? "ok" : "MISMATCH";
+    printf("%-14s %-22s %9.3f %s\n", "crossfade", blends[k].name, crossfade, verdict);
+    printf("%-14s %-22s %9.3f %s\n", "keyed blend", blends[k].name, keyed, verdict);
+    ok = ok && same;
+  }
+  return ok;
+}
+
+// --- Soak -----------------------------------------------------------------
+
+// One cover transition for the first app, one blend for every switch.
+constexpr const char* kSoakTransitions = R"([
+  {"name": "SoakWipe", "type": "wipe", "direction": "right", "frame_ms": 25, "frames": 20},
+  {"name": "SoakFade", "type": "crossfade", "frame_ms": 20, "frames": 30}
+])";
+constexpr int kSoakCoverFrames = 20;
+constexpr int kSoakCoverMs = 20 * 25;
+constexpr int kSoakBlendFrames = 30;
+constexpr int kSoakBlendMs = 30 * 20;
+
+struct SoakApp {
+  std::shared_ptr<DecodedContent> content;
+  int dwell_secs;
+  // What playing it must come to: whole loops until the dwell is over.
+  uint64_t frames = 0;
+  int64_t ms = 0;
+};
+
+SoakApp MakeSoakApp(uint64_t hash, int dwell_secs, const std::vector<int>& durations_ms) {
+  constexpr int kWidth = 64, kHeight = 32;
+  SoakApp app;
+  app.dwell_secs = dwell_secs;
+  auto content = std::make_shared<DecodedContent>();
+  content->hash = hash;
+  content->still = durations_ms.size() == 1;
+  FrameCache& frames = content->frames;
+  frames.width = kWidth;
+  frames.height = kHeight;
+  frames.durations_ms = durations_ms;
+  frames.pixels.resize(frames.frame_size() * durations_ms.size());
+  for (size_t i = 0; i < frames.pixels.size(); ++i) frames.pixels[i] = (i + hash * 37) & 255;
+  app.content = std::move(content);
+
+  if (durations_ms.size() == 1) {
+    app.frames = 1;
+    app.ms = dwell_secs * 1000;
+    return app;
+  }
+  int64_t loop_ms = 0;
+  for (int ms : durations_ms) loop_ms += ms;
+  const int64_t loops = (dwell_secs * 1000 + loop_ms - 1) / loop_ms;
+  app.frames = loops * durations_ms.size();
+  app.ms = loops * loop_ms;
+  return app;
+}
+
+bool Soak(double hours) {
+  std::vector<SoakApp> rotation;
+  rotation.push_back(MakeSoakApp(1, 10, {10000}));
+  rotation.push_back(MakeSoakApp(2, 5, std::vector<int>(12, 70)));
+  rotation.push_back(MakeSoakApp(3, 15, std::vector<int>(48, 100)));
+  rotation.push_back(MakeSoakApp(4, 3, {30, 250, 40, 90}));
+
+  // Plan the whole run: the first app gets a cover transition, every later
+  // one a blend from the app before it, and the last leads into nothing.
+  const int64_t target_ms = static_cast<int64_t>(hours * 3600 * 1000);
+  uint64_t apps = 0, expect_frames = 0;
+  int64_t expect_ms = 0;
+  while (expect_ms < target_ms) {
+    const SoakApp& app = rotation[apps % rotation.size()];
+    expect_frames += app.frames + (apps == 0 ? kSoakCoverFrames : kSoakBlendFrames);
+    expect_ms += app.ms + (apps == 0 ? kSoakCoverMs : kSoakBlendMs);
+    ++apps;
+  }
+
+  SimulatedTime time;
+  OffscreenSink display(64, 32);
+  TransitionEngine transitions(&time);
+  transitions.LoadText(kSoakTransitions, "soak transitions", display.width(),
+                       display.height());
+  PayloadRing payloads;  // stays empty: every app comes in decoded
+  DecodedRing decoded;
+  std::atomic<bool> render_waiting{false};
+  std::atomic<bool> fed{false};
+
+  // Decoding takes no time either: the feeder fills the ring before the
+  // clock moves on, so the render stage sees the same ring every run.
+  std::thread feeder([&] {
+    for (uint64_t i = 0; i < apps; ++i) {
+      DecodedApp* slot = decoded.WaitWrite();
+      if (slot == nullptr) return;
+      const SoakApp& app = rotation[i % rotation.size()];
+      slot->content = app.content;
+      slot->dwell_secs = app.dwell_secs;
+      slot->brightness = 0;
+      slot->preview = false;
+      decoded.CommitWrite();
+    }
+    fed.store(true);
+    decoded.Close();
+  });
+  // Both slots full: one playing, the next one waiting.
+  time.OnSleep([&] {
+    while (decoded.size() < 2 && !fed.load()) std::this_thread::yield();
+  });
+
+  const TimeSource::Clock::time_point start = time.Now();
+  const Clock::time_point real_start = Clock::now();
+  std::streambuf* log = std::cout.rdbuf(nullptr);  // one line per app otherwise
+  const RenderStats stats =
+      RunRenderStage(&display, &decoded, payloads, &transitions, &render_waiting, &time);
+  std::cout.rdbuf(log);
+  std::cout.clear();
+  feeder.join();
+  const double real_ms = Nanos(real_start, Clock::now()) / 1e6;
+  const int64_t ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(time.Now() - start).count();
+
+  printf("Soak: %llu apps, %llu frames over %.2f simulated hours in %.0f ms\n",
+         static_cast<unsigned long long>(stats.apps),
+         static_cast<unsigned long long>(display.swaps()), ms / 3.6e6, real_ms);
+  bool ok = true;
+  auto check = [&ok](const char* what, long long got, long long want) {
+    if (got == want) return;
+    printf("  %s: %lld, expected %lld\n", what, got, want);
+    ok = false;
+  };
+  check("apps", stats.apps, apps);
+  check("transitions", stats.transitions, apps);
+  check("frames shown", display.swaps(), expect_frames);
+  check("frames paced", stats.pacing.frames, expect_frames);
+  check("missed deadlines", stats.pacing.missed, 0);
+  check("dropped frames", stats.pacing.dropped, 0);
+  check("simulated ms", ms, expect_ms);
+  printf("%s\n", ok ? "Soak passed" : "Soak FAILED");
+  return ok;
+}
+
+Payload MakeCachedPayload(const std::string& body, int dwell_secs) {
+  Payload payload;
+  payload.body = body;
+  payload.hash = Fnv1a64(body.data(), body.size());
+  payload.dwell_secs = dwell_secs;
+  return payload;
+}
+
+// A Store that only reorders the index is written out lazily; a cache
+// reopened after the first one is gone must still see it.
+bool CheckDiskCache() {
+  char dir[] = "/tmp/tronberry_bench_XXXXXX";
+  if (mkdtemp(dir) == nullptr) {
+    fprintf(stderr, "Cannot create a disk cache directory\n");
+    return false;
+  }
+  const Payload first = MakeCachedPayload("first", 5);
+  const Payload second = MakeCachedPayload("second", 5);
+  {
+    DiskCache disk(dir, 1 << 20);
+    disk.Open();
+    disk.Store(first);
+    disk.Store(second);
+    disk.Store(MakeCachedPayload("first", 7));
+  }
+  // Least recently shown first: |second|, then |first| with its new dwell.
+  DiskCache reopened(dir, 1 << 20);
+  Payload a, b;
+  const bool ok = reopened.Open() && reopened.Next(&a) && reopened.Next(&b) &&
+                  a.hash == second.hash && b.hash == first.hash && b.dwell_secs == 7;
+  printf("\nDisk cache reopened %s\n", ok ? "with the last Store" : "WITHOUT the last Store");
+
+  for (const Payload* payload : {&first, &second}) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.webp",
+             static_cast<unsigned long long>(payload->hash));
+    unlink((std::string(dir) + name).c_str());
+  }
+  unlink((std::string(dir) + "/index").c_str());
+  rmdir(dir);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--soak") == 0) {
+    return Soak(argc > 2 ? atof(argv[2]) : 6) ? 0 : 1;
+  }
+
+  ColorPipeline color;
+  std::vector<CorpusItem> corpus = BuildCorpus();
+  printf("Corpus: %zu WebPs; colour kernel %s, blend kernel %s\n", corpus.size(),
+         color.kernel_name(), BestBlendKernel().name);
+
+  const bool kernels_ok = BenchKernels(color);
+  BenchPipeline(corpus, color);
+  BenchTransitions();
+  const bool disk_ok = CheckDiskCache();
+  if (!kernels_ok) {
+    fprintf(stderr, "\nA kernel disagrees with the scalar reference\n");
+    return 1;
+  }
+  return disk_ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include "blend_kernels.h"
+
+#include "color.h"
+#include "simd_util.h"
+
+void CrossfadeScalar(const uint8_t* from, const uint8_t* to, uint8_t* out,
+                     int count, int weight) {
+  const uint32_t w = weight;
+  for (int i = 0; i < count; ++i) {
+    out[i] = Div255(from[i] * (255 - w) + to[i] * w);
+  }
+}
+
+void KeyedBlendScalar(const uint8_t* from, const uint8_t* to, const uint16_t* key,
+                      uint8_t* out, int count, int front) {
+  for (int i = 0; i < count; ++i) {
+    int d = front - key[i];
+    const uint32_t w = d < 0 ? 0 : d > 255 ? 255 : d;
+    out[i] = Div255(from[i] * (255 - w) + to[i] * w);
+  }
+}
+
+namespace {
+
+#if defined(TRONBERRY_X86_KERNELS)
+
+// Blends eight 16-bit lanes holding bytes; the sum stays within 16 bits.
+__attribute__((target("sse2"))) inline __m128i BlendSSE2(__m128i from, __m128i to,
+                                                         __m128i w) {
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i x = _mm_add_epi16(_mm_mullo_epi16(from, _mm_sub_epi16(_mm_set1_epi16(255), w)),
+                            _mm_mullo_epi16(to, w));
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+}
+
+// min(max(front - key, 0), 255) with unsigned saturation only.
+__attribute__((target("sse2"))) inline __m128i KeyWeightSSE2(__m128i front,
+                                                             const uint16_t* key) {
+  __m128i d = _mm_subs_epu16(
+      front, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key)));
+  return _mm_subs_epu16(d, _mm_subs_epu16(d, _mm_set1_epi16(255)));
+}
+
+__attribute__((target("sse2"))) void CrossfadeSSE2(const uint8_t* from, const uint8_t* to,
+                                                   uint8_t* out, int count, int weight) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i w = _mm_set1_epi16(static_cast<int16_t>(weight));
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+    __m128i lo = BlendSSE2(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(t, zero), w);
+    __m128i hi = BlendSSE2(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(t, zero), w);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+  }
+  CrossfadeScalar(from + i, to + i, out + i, count - i, weight);
+}
+
+__attribute__((target("sse2"))) void KeyedBlendSSE2(const uint8_t* from, const uint8_t* to,
+                                                    const uint16_t* key, uint8_t* out,
+                                                    int count, int front) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i f16 = _mm_set1_epi16(static_cast<int16_t>(front));
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+    __m128i lo = BlendSSE2(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(t, zero),
+                           KeyWeightSSE2(f16, key + i));
+    __m128i hi = BlendSSE2(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(t, zero),
+                           KeyWeightSSE2(f16, key + i + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+  }
+  KeyedBlendScalar(from + i, to + i, key + i, out + i, count - i, front);
+}
+
+__attribute__((target("avx2"))) inline __m256i BlendAVX2(const uint8_t* from,
+                                                         const uint8_t* to, __m256i w) {
+  const __m256i one = _mm256_set1_epi16(1);
+  __m256i f = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(from)));
+  __m256i t = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(to)));
+  __m256i x = _mm256_add_epi16(
+      _mm256_mullo_epi16(f, _mm256_sub_epi16(_mm256_set1_epi16(255), w)),
+      _mm256_mullo_epi16(t, w));
+  return _mm256_srli_epi16(
+      _mm256_add_epi16(_mm256_add_epi16(x, one), _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Packs sixteen 16-bit lanes back into bytes, in order.
+__attribute__((target("avx2"))) inline void Store16AVX2(uint8_t* out, __m256i x) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm_packus_epi16(_mm256_castsi256_si128(x),
+                                    _mm256_extracti128_si256(x, 1)));
+}
+
+__attribute__((target("avx2"))) void CrossfadeAVX2(const uint8_t* from, const uint8_t* to,
+                                                   uint8_t* out, int count, int weight) {
+  const __m256i w = _mm256_set1_epi16(static_cast<int16_t>(weight));
+  int i = 0;
+  for (; i + 32 <= count; i += 32) {
+    Store16AVX2(out + i, BlendAVX2(from + i, to + i, w));
+    Store16AVX2(out + i + 16, BlendAVX2(from + i + 16, to + i + 16, w));
+  }
+  CrossfadeScalar(from + i, to + i, out + i, count - i, weight);
+}
+
+__attribute__((target("avx2"))) void KeyedBlendAVX2(const uint8_t* from, const uint8_t* to,
+                                                    const uint16_t* key, uint8_t* out,
+                                                    int count, int front) {
+  const __m256i f16 = _mm256_set1_epi16(static_cast<int16_t>(front));
+  const __m256i v255 = _mm256_set1_epi16(255);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i d = _mm256_subs_epu16(
+        f16, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + i)));
+    Store16AVX2(out + i, BlendAVX2(from + i, to + i, _mm256_min_epu16(d, v255)));
+  }
+  KeyedBlendScalar(from + i, to + i, key + i, out + i, count - i, front);
+}
+
+#endif  // TRONBERRY_X86_KERNELS
+
+#if defined(TRONBERRY_NEON_KERNELS)
+
+inline uint8x8_t BlendNEON(uint8x8_t from, uint8x8_t to, uint16x8_t w) {
+  uint16x8_t x = vmulq_u16(vmovl_u8(from), vsubq_u16(vdupq_n_u16(255), w));
+  return Div255NEON(vmlaq_u16(x, vmovl_u8(to), w));
+}
+
+void CrossfadeNEON(const uint8_t* from, const uint8_t* to, uint8_t* out, int count,
+                   int weight) {
+  const uint8x8_t w = vdup_n_u8(static_cast<uint8_t>(weight));
+  const uint8x8_t inv = vdup_n_u8(static_cast<uint8_t>(255 - weight));
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x16_t f = vld1q_u8(from + i);
+    uint8x16_t t = vld1q_u8(to + i);
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(f), inv), vget_low_u8(t), w);
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(f), inv), vget_high_u8(t), w);
+    vst1q_u8(out + i, vcombine_u8(Div255NEON(lo), Div255NEON(hi)));
+  }
+  CrossfadeScalar(from + i, to + i, out + i, count - i, weight);
+}
+
+void KeyedBlendNEON(const uint8_t* from, const uint8_t* to, const uint16_t* key,
+                    uint8_t* out, int count, int front) {
+  const uint16x8_t f16 = vdupq_n_u16(static_cast<uint16_t>(front));
+  const uint16x8_t v255 = vdupq_n_u16(255);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x16_t f = vld1q_u8(from + i);
+    uint8x16_t t = vld1q_u8(to + i);
+    uint16x8_t w_lo = vminq_u16(vqsubq_u16(f16, vld1q_u16(key + i)), v255);
+    uint16x8_t w_hi = vminq_u16(vqsubq_u16(f16, vld1q_u16(key + i + 8)), v255);
+    vst1q_u8(out + i, vcombine_u8(BlendNEON(vget_low_u8(f), vget_low_u8(t), w_lo),
+                                  BlendNEON(vget_high_u8(f), vget_high_u8(t), w_hi)));
+  }
+  KeyedBlendScalar(from + i, to + i, key + i, out + i, count - i, front);
+}
+
+#endif  // TRONBERRY_NEON_KERNELS
+
+const KernelTable<BlendKernel, 3>& Kernels() {
+  static const KernelTable<BlendKernel, 3> table = [] {
+    KernelTable<BlendKernel, 3> table;
+    table.Add({"scalar", CrossfadeScalar, KeyedBlendScalar});
+#if defined(TRONBERRY_X86_KERNELS)
+    if (__builtin_cpu_supports("sse2")) {
+      table.Add({"sse2", CrossfadeSSE2, KeyedBlendSSE2});
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      table.Add({"avx2", CrossfadeAVX2, KeyedBlendAVX2});
+    }
+#elif defined(TRONBERRY_NEON_KERNELS)
+    if (HasNEON()) table.Add({"neon", CrossfadeNEON, KeyedBlendNEON});
+#endif
+    return table;
+  }();
+  return table;
+}
+
+}  // namespace
+
+const BlendKernel& BestBlendKernel() { return Kernels().best(); }
+
+int AvailableBlendKernels(const BlendKernel** kernels) { return Kernels().List(kernels); }
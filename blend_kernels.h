@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Kernels that blend two packed RGB images byte by byte into |out|:
+//
+//   out = Div255(from * (255 - w) + to * w)
+//
+// Crossfade uses one weight |w| (0..255) for every byte. Keyed blends give
+// every byte a 16-bit |key| and take w = min(max(front - key, 0), 255), so
+// a wipe or dissolve is a key table plus one moving |front|. Every kernel
+// must match its scalar version bit for bit.
+using CrossfadeFn = void (*)(const uint8_t* from, const uint8_t* to, uint8_t* out,
+                             int count, int weight);
+using KeyedBlendFn = void (*)(const uint8_t* from, const uint8_t* to,
+                              const uint16_t* key, uint8_t* out, int count,
+                              int front);
+
+struct BlendKernel {
+  const char* name;
+  CrossfadeFn crossfade;
+  KeyedBlendFn keyed;
+};
+
+void CrossfadeScalar(const uint8_t* from, const uint8_t* to, uint8_t* out,
+                     int count, int weight);
+void KeyedBlendScalar(const uint8_t* from, const uint8_t* to, const uint16_t* key,
+                      uint8_t* out, int count, int front);
+
+// The fastest kernels supported by the CPU we are running on, picked once.
+const BlendKernel& BestBlendKernel();
+
+// Every kernel set compiled in and supported at runtime, scalar first, so
+// callers can check the vector versions against the reference. Returns the
+// count.
+int AvailableBlendKernels(const BlendKernel** kernels);
@@ -0,0 +1,38 @@
+#include "blit.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+static_assert(sizeof(rgb_matrix::Color) == 3,
+              "packed RGB rows are passed to SetPixels as Color arrays");
+
+void RgbFrame::Resize(int w, int h) {
+  width = w;
+  height = h;
+  pixels.assign(static_cast<size_t>(w) * h * 3, 0);
+}
+
+void RgbFrame::Clear() { memset(pixels.data(), 0, pixels.size()); }
+
+void BlitRGB(rgb_matrix::FrameCanvas* canvas, int x, int y, int width,
+             int height, const uint8_t* rgb, int stride) {
+  int x0 = std::max(x, 0);
+  int y0 = std::max(y, 0);
+  int x1 = std::min(x + width, canvas->width());
+  int y1 = std::min(y + height, canvas->height());
+  if (x0 >= x1 || y0 >= y1) return;
+
+  const uint8_t* src = rgb + (y0 - y) * stride + (x0 - x) * 3;
+  auto* colors = reinterpret_cast<rgb_matrix::Color*>(const_cast<uint8_t*>(src));
+  const int run = x1 - x0;
+
+  if (stride == run * 3) {
+    canvas->SetPixels(x0, y0, run, y1 - y0, colors);
+    return;
+  }
+  for (int row = y0; row < y1; ++row, src += stride) {
+    colors = reinterpret_cast<rgb_matrix::Color*>(const_cast<uint8_t*>(src));
+    canvas->SetPixels(x0, row, run, 1, colors);
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "led-matrix.h"
+
+// Packed RGB image that transitions and the splash draw into off-panel
+// before handing the whole frame to the canvas with BlitFrame.
+struct RgbFrame {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+
+  // Resizes to |w| x |h| and clears to black.
+  void Resize(int w, int h);
+  void Clear();
+
+  uint8_t* row(int y) { return pixels.data() + static_cast<size_t>(y) * width * 3; }
+  const uint8_t* row(int y) const {
+    return pixels.data() + static_cast<size_t>(y) * width * 3;
+  }
+  void SetPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    uint8_t* p = row(y) + x * 3;
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+  }
+};
+
+// Writes a |width| x |height| packed RGB image whose rows are |stride| bytes
+// apart into |canvas| at (x, y). The image is clipped to the canvas once up
+// front and handed over with bulk SetPixels calls instead of one virtual
+// SetPixel per pixel.
+void BlitRGB(rgb_matrix::FrameCanvas* canvas, int x, int y, int width,
+             int height, const uint8_t* rgb, int stride);
+
+inline void BlitFrame(rgb_matrix::FrameCanvas* canvas, const RgbFrame& frame) {
+  BlitRGB(canvas, 0, 0, frame.width, frame.height, frame.pixels.data(),
+          frame.width * 3);
+}
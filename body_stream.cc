@@ -0,0 +1,81 @@
+#include "body_stream.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "content_cache.h"
+
+namespace {
+
+// Content-Length comes from the server, so it is only trusted this far for
+// reserving up front; a body that really is larger grows past it.
+constexpr size_t kMaxReserve = 8u << 20;
+
+}  // namespace
+
+void BodyStream::Start(size_t expected) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bytes_.clear();
+  bytes_.reserve(std::min(expected, kMaxReserve));
+  hash_ = kFnvOffset;
+  done_ = false;
+  ok_ = false;
+}
+
+void BodyStream::Append(const char* data, size_t len) {
+  // Only the writer touches the hash; readers see it after Finish().
+  hash_ = Fnv1a64(data, len, hash_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_.insert(bytes_.end(), data, data + len);
+  }
+  grew_.notify_all();
+}
+
+void BodyStream::Finish(bool ok) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    ok_ = ok;
+  }
+  grew_.notify_all();
+}
+
+bool BodyStream::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  grew_.wait(lock, [this] { return done_; });
+  return ok_;
+}
+
+BodyStreamPool::BodyStreamPool(size_t count) : entries_(count) {
+  for (Entry& entry : entries_) {
+    entry.stream = std::make_unique<BodyStream>();
+  }
+}
+
+BodyStream* BodyStreamPool::Acquire(size_t expected) {
+  expected = std::min(expected, kMaxReserve);
+  // The tightest buffer that already fits, else the roomiest one to grow.
+  auto rank = [expected](const Entry& entry) {
+    size_t capacity = entry.stream->capacity();
+    return capacity >= expected ? std::pair<int, size_t>(0, capacity)
+                                : std::pair<int, size_t>(1, SIZE_MAX - capacity);
+  };
+  Entry* best = nullptr;
+  for (Entry& entry : entries_) {
+    if (entry.in_use) continue;
+    if (best == nullptr || rank(entry) < rank(*best)) best = &entry;
+  }
+  if (best == nullptr) return nullptr;
+  best->in_use = true;
+  best->stream->Start(expected);
+  return best->stream.get();
+}
+
+void BodyStreamPool::Release(BodyStream* stream) {
+  for (Entry& entry : entries_) {
+    if (entry.stream.get() == stream) entry.in_use = false;
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A response body that is still arriving. The fetch stage appends chunks as
+// httplib receives them and the decode stage reads whatever has landed so
+// far, so decoding can start before the last byte. The content hash is
+// folded in chunk by chunk. Once Finish() has been called the bytes never
+// change again and data()/size() may be read without locking.
+class BodyStream {
+ public:
+  // Fetch side. Start() readies the stream for a new body, keeping the
+  // buffer; |expected| is the Content-Length, or 0 when there was none.
+  // At most 8 MB of it is reserved up front.
+  void Start(size_t expected);
+  void Append(const char* data, size_t len);
+  void Finish(bool ok);
+
+  // Decode side. Blocks until more than |have| bytes have arrived or the
+  // transfer has ended, then runs |fn(data, size, done)| with the writer
+  // held off, so |data| stays valid for the duration of the call.
+  template <typename Fn>
+  void Read(size_t have, Fn&& fn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    grew_.wait(lock, [&] { return bytes_.size() > have || done_; });
+    fn(bytes_.data(), bytes_.size(), done_);
+  }
+
+  // Blocks until the transfer has ended. Returns false if it failed.
+  bool Wait();
+
+  // Only valid once Wait() has returned true.
+  const uint8_t* data() const { return bytes_.data(); }
+  size_t size() const { return bytes_.size(); }
+  uint64_t hash() const { return hash_; }
+  size_t capacity() const { return bytes_.capacity(); }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable grew_;
+  std::vector<uint8_t> bytes_;
+  uint64_t hash_ = 0;
+  bool done_ = false;
+  bool ok_ = false;
+};
+
+// Receive buffers reused from one response to the next. Each request takes
+// the free stream whose buffer already fits its Content-Length, so once the
+// rotation has been through once, receiving a body allocates nothing. Not
+// thread-safe; owned by the fetch stage, which hands a stream back when the
+// ring slot that carried it comes round again.
+class BodyStreamPool {
+ public:
+  explicit BodyStreamPool(size_t count);
+
+  // Returns nullptr if every stream is in use.
+  BodyStream* Acquire(size_t expected);
+  void Release(BodyStream* stream);
+
+ private:
+  struct Entry {
+    std::unique_ptr<BodyStream> stream;
+    bool in_use = false;
+  };
+  std::vector<Entry> entries_;
+};
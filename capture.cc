@@ -0,0 +1,210 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// Capture layout: "TBCP", then one record per response, all integers
+// varints (LEB128):
+//
+//   at (microseconds since the previous record), ttfb, transfer,
+//   status, httplib::Error, header count,
+//   per header: name length, name, value length, value,
+//   body length, body
+
+namespace {
+
+constexpr uint8_t kMagic[4] = {'T', 'B', 'C', 'P'};
+
+// Body pieces handed over during a replayed transfer.
+constexpr size_t kReplayChunk = 4096;
+
+void PutVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutString(const std::string& value, std::string* out) {
+  PutVarint(value.size(), out);
+  out->append(value);
+}
+
+// Reads records out of a whole capture file; every read fails once the
+// data runs out.
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+  bool at_end() const { return p_ == end_; }
+
+  bool Varint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (p_ == end_) return false;
+      uint8_t byte = *p_++;
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool String(std::string* value) {
+    uint64_t size;
+    if (!Varint(&size) || size > static_cast<size_t>(end_ - p_)) return false;
+    value->assign(reinterpret_cast<const char*>(p_), size);
+    p_ += size;
+    return true;
+  }
+
+ private:
+  const uint8_t* p_;
+  const uint8_t* end_;
+};
+
+bool ReadRecord(Reader* in, CapturedResponse::Duration last_at, CapturedResponse* out) {
+  uint64_t at, ttfb, transfer, status, error, headers;
+  if (!in->Varint(&at) || !in->Varint(&ttfb) || !in->Varint(&transfer) ||
+      !in->Varint(&status) || !in->Varint(&error) || !in->Varint(&headers)) {
+    return false;
+  }
+  out->at = last_at + CapturedResponse::Duration(at);
+  out->ttfb = CapturedResponse::Duration(ttfb);
+  out->transfer = CapturedResponse::Duration(transfer);
+  out->status = static_cast<int>(status);
+  out->error = static_cast<httplib::Error>(error);
+  for (uint64_t i = 0; i < headers; ++i) {
+    std::string name, value;
+    if (!in->String(&name) || !in->String(&value)) return false;
+    out->headers.emplace(std::move(name), std::move(value));
+  }
+  return in->String(&out->body);
+}
+
+}  // namespace
+
+CaptureWriter::~CaptureWriter() {
+  if (file_ != nullptr) fclose(file_);
+}
+
+bool CaptureWriter::Open(const std::string& path) {
+  file_ = fopen(path.c_str(), "wb");
+  if (file_ == nullptr || fwrite(kMagic, 1, sizeof(kMagic), file_) != sizeof(kMagic)) {
+    std::cerr << "Cannot write capture " << path << std::endl;
+    return false;
+  }
+  start_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+CapturedResponse::Duration CaptureWriter::Now() const {
+  return std::chrono::duration_cast<CapturedResponse::Duration>(
+      std::chrono::steady_clock::now() - start_);
+}
+
+void CaptureWriter::Write(const CapturedResponse& response) {
+  if (file_ == nullptr) return;
+  std::string record;
+  record.reserve(response.body.size() + 256);
+  PutVarint(std::max(response.at - last_at_, CapturedResponse::Duration(0)).count(),
+            &record);
+  PutVarint(response.ttfb.count(), &record);
+  PutVarint(response.transfer.count(), &record);
+  PutVarint(response.status, &record);
+  PutVarint(static_cast<uint64_t>(response.error), &record);
+  PutVarint(response.headers.size(), &record);
+  for (const auto& [name, value] : response.headers) {
+    PutString(name, &record);
+    PutString(value, &record);
+  }
+  PutString(response.body, &record);
+  last_at_ = std::max(response.at, last_at_);
+
+  if (fwrite(record.data(), 1, record.size(), file_) != record.size() ||
+      fflush(file_) != 0) {
+    std::cerr << "Capture write failed, stopping capture" << std::endl;
+    fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+bool CaptureReplay::Open(const std::string& path, TimeSource* time) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Cannot read capture " << path << std::endl;
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(kMagic) || !std::equal(kMagic, kMagic + 4, data.begin())) {
+    std::cerr << path << " is not a capture" << std::endl;
+    return false;
+  }
+
+  Reader in(data.data() + sizeof(kMagic), data.size() - sizeof(kMagic));
+  responses_.clear();
+  Duration last_at{0};
+  while (!in.at_end()) {
+    CapturedResponse response;
+    if (!ReadRecord(&in, last_at, &response)) {
+      std::cerr << "⚠️ " << path << " ends mid-record after " << responses_.size()
+                << " responses" << std::endl;
+      break;
+    }
+    last_at = response.at;
+    responses_.push_back(std::move(response));
+  }
+  next_ = 0;
+  time_ = time;
+  start_ = time->Now();
+  return true;
+}
+
+CaptureReplay::Duration CaptureReplay::Now() const {
+  return std::chrono::duration_cast<Duration>(time_->Now() - start_);
+}
+
+void CaptureReplay::WaitUntil(Duration at) {
+  if (at > Now()) time_->SleepUntil(start_ + at);
+}
+
+httplib::Result CaptureReplay::Get(const httplib::Headers& headers,
+                                   httplib::ResponseHandler on_response,
+                                   httplib::ContentReceiver on_body, FetchTiming* timing) {
+  *timing = FetchTiming();
+  timing->reused = true;
+  if (done()) return httplib::Result(nullptr, httplib::Error::Canceled);
+  const CapturedResponse& recorded = responses_[next_++];
+
+  const Duration sent = Now();
+  WaitUntil(std::max(recorded.at, sent + recorded.ttfb));
+  const Duration headers_in = Now();
+  timing->ttfb = headers_in - sent;
+  if (recorded.status == 0) return httplib::Result(nullptr, recorded.error);
+
+  auto response = std::make_unique<httplib::Response>();
+  response->status = recorded.status;
+  response->headers = recorded.headers;
+  if (!on_response(*response)) return httplib::Result(nullptr, httplib::Error::Canceled);
+
+  const std::string& body = recorded.body;
+  const size_t chunks = std::max<size_t>((body.size() + kReplayChunk - 1) / kReplayChunk, 1);
+  for (size_t i = 0, offset = 0; offset < body.size(); ++i) {
+    WaitUntil(headers_in + recorded.transfer * static_cast<int64_t>(i + 1) /
+                               static_cast<int64_t>(chunks));
+    const size_t n = std::min(kReplayChunk, body.size() - offset);
+    if (!on_body(body.data() + offset, n)) {
+      return httplib::Result(nullptr, httplib::Error::Canceled);
+    }
+    offset += n;
+    timing->bytes += n;
+  }
+  timing->transfer = Now() - headers_in;
+  if (recorded.error != httplib::Error::Success) {
+    return httplib::Result(nullptr, recorded.error);
+  }
+  return httplib::Result(std::move(response), httplib::Error::Success);
+}
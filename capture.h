@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "http_client.h"
+#include "httplib.h"
+#include "time_source.h"
+
+// One response as the fetch stage received it, or a request that got none.
+struct CapturedResponse {
+  using Duration = std::chrono::microseconds;
+  Duration at{0};        // headers in, or the request failed, since the capture began
+  Duration ttfb{0};      // request sent to headers in
+  Duration transfer{0};  // headers in to the last body byte
+  int status = 0;        // 0 when no response arrived
+  httplib::Error error = httplib::Error::Success;
+  httplib::Headers headers;
+  std::string body;  // as much of it as arrived
+};
+
+// Appends every response to a capture file as it comes in, flushed each
+// time, so a trace taken on a misbehaving device survives it being killed.
+class CaptureWriter {
+ public:
+  CaptureWriter() = default;
+  ~CaptureWriter();
+
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  // Starts a new capture in |path|, and its clock.
+  bool Open(const std::string& path);
+
+  // Time since Open, for CapturedResponse::at.
+  CapturedResponse::Duration Now() const;
+
+  void Write(const CapturedResponse& response);
+
+ private:
+  FILE* file_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+  CapturedResponse::Duration last_at_{0};
+};
+
+// Plays a capture back in place of the server, through the same fetch
+// handling as live responses. Each response is handed over once the
+// capture's clock reaches the time it arrived (or, if the replay is behind,
+// its time to first byte after the request), and its body in pieces spread
+// over the recorded transfer time. The capture's clock is the TimeSource the
+// replay is opened with, which should also pace the rest of the pipeline: a
+// ScaledTime to run the capture faster than it was taken, or a
+// SimulatedTime to skip every wait and run as fast as the pipeline can.
+class CaptureReplay {
+ public:
+  using Duration = CapturedResponse::Duration;
+
+  // Reads all of |path| and starts its clock on |time|. A record cut short
+  // at the end (the capture was killed mid-write) is dropped with a warning.
+  bool Open(const std::string& path, TimeSource* time);
+
+  // Every response has been handed out.
+  bool done() const { return next_ >= responses_.size(); }
+  size_t size() const { return responses_.size(); }
+
+  // Stands in for HttpClient::Get. Returns a failed Result with
+  // httplib::Error::Canceled once done().
+  httplib::Result Get(const httplib::Headers& headers,
+                      httplib::ResponseHandler on_response,
+                      httplib::ContentReceiver on_body, FetchTiming* timing);
+
+ private:
+  Duration Now() const;
+  void WaitUntil(Duration at);
+
+  std::vector<CapturedResponse> responses_;
+  size_t next_ = 0;
+  TimeSource* time_ = nullptr;
+  TimeSource::Clock::time_point start_;
+};
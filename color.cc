@@ -0,0 +1,64 @@
+#include "color.h"
+
+#include "color_kernels.h"
+
+namespace {
+
+uint8_t ToByte(double value) {
+  return static_cast<uint8_t>(std::min(1.0, value) * 255.0f);
+}
+
+}  // namespace
+
+ColorPipeline::ColorPipeline(const ColorParams& params) { Configure(params); }
+
+void ColorPipeline::Configure(const ColorParams& params) {
+  params_ = params;
+  lift_ = params.min_floor > 0.0f;
+
+  const double gamma = params.gamma;
+  const double brightness = params.brightness;
+
+  for (int c = 0; c < 256; ++c) {
+    gamma_[c] = ToByte(pow(c / 255.0f, params.gamma) * brightness);
+  }
+  if (!lift_) return;
+
+  for (int i = 0; i < kFineSize; ++i) {
+    double premul = ((i << kFineShift) + (1 << (kFineShift - 1))) / 65025.0;
+    fine_[i] = ToByte(std::pow(std::min(1.0, premul), gamma) * brightness);
+  }
+
+  // Smallest max_channel * alpha product whose gamma-corrected value reaches
+  // the floor.
+  lift_below_ = 65026;
+  for (uint32_t product = 0; product <= 65025; ++product) {
+    if (std::pow(product / 65025.0, gamma) >= params.min_floor) {
+      lift_below_ = product;
+      break;
+    }
+  }
+
+  const double lifted = params.min_floor * brightness;
+  for (int m = 0; m < 256; ++m) {
+    for (int c = 0; c < 256; ++c) {
+      ratio_[m][c] =
+          (m == 0 || c > m) ? 0 : ToByte(std::pow(double(c) / m, gamma) * lifted);
+    }
+  }
+}
+
+void ColorPipeline::ConvertRow(const uint8_t* rgba, uint8_t* rgb,
+                               int count) const {
+  if (!lift_) {
+    BestRowKernel().fn(gamma_, params_.black_threshold, rgba, rgb, count);
+    return;
+  }
+  for (int i = 0; i < count; ++i) {
+    Convert(rgba + i * 4, rgb + i * 3);
+  }
+}
+
+const char* ColorPipeline::kernel_name() const {
+  return lift_ ? "scalar-lift" : BestRowKernel().name;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+
+inline uint8_t ApplyGamma(uint8_t color, float gamma = 2.2f) {
+    return static_cast<uint8_t>(pow(color / 255.0f, gamma) * 255.0f);
+}
+
+// Exact floor(x / 255) for any product of two bytes.
+inline uint32_t Div255(uint32_t x) { return (x + 1 + (x >> 8)) >> 8; }
+
+struct ColorParams {
+  float gamma = 2.2f;
+  // Pixels whose brightest channel falls below this (after gamma) are lifted
+  // to it, keeping their hue. 0 disables the lift.
+  float min_floor = 0.0f;
+  float brightness = 1.0f;
+  // Pixels with alpha, or r+g+b, below this are forced to black.
+  int black_threshold = 0;
+};
+
+// Table-driven replacement for the per-pixel pow() in ApplyGamma and the old
+// ProcessPixel. Everything per pixel is integer math and table lookups:
+//
+//  - Without a floor, the alpha premultiply is truncated to a byte and looked
+//    up in a 256-entry gamma table, which reproduces
+//    ApplyGamma(uint8_t(c * (a / 255.0f))) bit for bit.
+//  - With a floor (ProcessPixel semantics), lit pixels index a finer ramp by
+//    the untruncated c * a product, and dim pixels use the fact that
+//    pow(c*a, g) / pow(max*a, g) == pow(c / max, g): a 256x256 table indexed
+//    by the unpremultiplied max channel and the channel itself. This stays
+//    within one step of the float version.
+class ColorPipeline {
+ public:
+  explicit ColorPipeline(const ColorParams& params = ColorParams());
+
+  void Configure(const ColorParams& params);
+  const ColorParams& params() const { return params_; }
+
+  bool lifts_dim_pixels() const { return lift_; }
+  const uint8_t* gamma_table() const { return gamma_; }
+
+  void Convert(const uint8_t* rgba, uint8_t* rgb) const {
+    uint32_t r = rgba[0], g = rgba[1], b = rgba[2], a = rgba[3];
+    if (static_cast<int>(a) < params_.black_threshold ||
+        static_cast<int>(r + g + b) < params_.black_threshold) {
+      rgb[0] = rgb[1] = rgb[2] = 0;
+      return;
+    }
+    if (!lift_) {
+      rgb[0] = gamma_[Div255(r * a)];
+      rgb[1] = gamma_[Div255(g * a)];
+      rgb[2] = gamma_[Div255(b * a)];
+      return;
+    }
+    uint32_t m = std::max({r, g, b});
+    if (m * a < lift_below_) {
+      const uint8_t* row = ratio_[m];
+      rgb[0] = row[r];
+      rgb[1] = row[g];
+      rgb[2] = row[b];
+    } else {
+      rgb[0] = fine_[(r * a) >> kFineShift];
+      rgb[1] = fine_[(g * a) >> kFineShift];
+      rgb[2] = fine_[(b * a) >> kFineShift];
+    }
+  }
+
+  // Converts |count| RGBA pixels into packed RGB. Without a floor this runs
+  // the best vector kernel for the CPU (see color_kernels.h).
+  void ConvertRow(const uint8_t* rgba, uint8_t* rgb, int count) const;
+  const char* kernel_name() const;
+
+ private:
+  static constexpr int kFineShift = 6;
+  static constexpr int kFineSize = (255 * 255 >> kFineShift) + 1;
+
+  ColorParams params_;
+  bool lift_ = false;
+  uint32_t lift_below_ = 0;  // max_channel * alpha products below this lift
+  uint8_t gamma_[256];
+  uint8_t fine_[kFineSize];
+  uint8_t ratio_[256][256];
+};
@@ -0,0 +1,204 @@
+#include "color_kernels.h"
+
+#include "color.h"
+#include "simd_util.h"
+
+void ConvertRowScalar(const uint8_t* gamma, int threshold, const uint8_t* rgba,
+                      uint8_t* rgb, int count) {
+  for (int i = 0; i < count; ++i, rgba += 4, rgb += 3) {
+    uint32_t a = rgba[3];
+    if (static_cast<int>(a) < threshold ||
+        static_cast<int>(rgba[0] + rgba[1] + rgba[2]) < threshold) {
+      rgb[0] = rgb[1] = rgb[2] = 0;
+      continue;
+    }
+    rgb[0] = gamma[Div255(rgba[0] * a)];
+    rgb[1] = gamma[Div255(rgba[1] * a)];
+    rgb[2] = gamma[Div255(rgba[2] * a)];
+  }
+}
+
+namespace {
+
+// Gamma lookup for pixels already premultiplied (and masked) in place.
+inline void LookupPremultiplied(const uint8_t* gamma, const uint8_t* premul,
+                                uint8_t* rgb, int count) {
+  for (int i = 0; i < count; ++i, premul += 4, rgb += 3) {
+    rgb[0] = gamma[premul[0]];
+    rgb[1] = gamma[premul[1]];
+    rgb[2] = gamma[premul[2]];
+  }
+}
+
+#if defined(TRONBERRY_X86_KERNELS)
+
+__attribute__((target("ssse3"))) inline __m128i PremultiplySSSE3(
+    __m128i px, __m128i threshold) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i alpha_shuffle =
+      _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+  __m128i alpha = _mm_shuffle_epi8(px, alpha_shuffle);
+
+  __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(px, zero),
+                               _mm_unpacklo_epi8(alpha, zero));
+  __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(px, zero),
+                               _mm_unpackhi_epi8(alpha, zero));
+  lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+  hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+  __m128i premul = _mm_packus_epi16(lo, hi);
+
+  // Per-pixel r+g+b and alpha as 32-bit lanes.
+  __m128i sum = _mm_madd_epi16(
+      _mm_maddubs_epi16(px, _mm_set1_epi32(0x00010101)), one);
+  __m128i a32 = _mm_srli_epi32(px, 24);
+  __m128i dark = _mm_or_si128(_mm_cmplt_epi32(sum, threshold),
+                              _mm_cmplt_epi32(a32, threshold));
+  return _mm_andnot_si128(dark, premul);
+}
+
+__attribute__((target("ssse3"))) void ConvertRowSSSE3(
+    const uint8_t* gamma, int threshold, const uint8_t* rgba, uint8_t* rgb,
+    int count) {
+  const __m128i t = _mm_set1_epi32(threshold);
+  alignas(16) uint8_t premul[32];
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4 + 16));
+    _mm_store_si128(reinterpret_cast<__m128i*>(premul), PremultiplySSSE3(a, t));
+    _mm_store_si128(reinterpret_cast<__m128i*>(premul + 16), PremultiplySSSE3(b, t));
+    LookupPremultiplied(gamma, premul, rgb + i * 3, 8);
+  }
+  ConvertRowScalar(gamma, threshold, rgba + i * 4, rgb + i * 3, count - i);
+}
+
+__attribute__((target("avx2"))) void ConvertRowAVX2(
+    const uint8_t* gamma, int threshold, const uint8_t* rgba, uint8_t* rgb,
+    int count) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i t = _mm256_set1_epi32(threshold);
+  const __m256i alpha_shuffle = _mm256_setr_epi8(
+      3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15,
+      3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+  alignas(32) uint8_t premul[64];
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    for (int half = 0; half < 2; ++half) {
+      __m256i px = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(rgba + (i + half * 8) * 4));
+      __m256i alpha = _mm256_shuffle_epi8(px, alpha_shuffle);
+
+      // unpack/pack stay within 128-bit lanes, so pixel order is preserved.
+      __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(px, zero),
+                                      _mm256_unpacklo_epi8(alpha, zero));
+      __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(px, zero),
+                                      _mm256_unpackhi_epi8(alpha, zero));
+      lo = _mm256_srli_epi16(
+          _mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+      hi = _mm256_srli_epi16(
+          _mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+      __m256i out = _mm256_packus_epi16(lo, hi);
+
+      __m256i sum = _mm256_madd_epi16(
+          _mm256_maddubs_epi16(px, _mm256_set1_epi32(0x00010101)), one);
+      __m256i a32 = _mm256_srli_epi32(px, 24);
+      __m256i dark = _mm256_or_si256(_mm256_cmpgt_epi32(t, sum),
+                                     _mm256_cmpgt_epi32(t, a32));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(premul + half * 32),
+                         _mm256_andnot_si256(dark, out));
+    }
+    LookupPremultiplied(gamma, premul, rgb + i * 3, 16);
+  }
+  ConvertRowScalar(gamma, threshold, rgba + i * 4, rgb + i * 3, count - i);
+}
+
+#endif  // TRONBERRY_X86_KERNELS
+
+#if defined(TRONBERRY_NEON_KERNELS)
+
+inline uint8x16_t PremultiplyNEON(uint8x16_t c, uint8x16_t a) {
+  return vcombine_u8(Div255NEON(vmull_u8(vget_low_u8(c), vget_low_u8(a))),
+                     Div255NEON(vmull_u8(vget_high_u8(c), vget_high_u8(a))));
+}
+
+// 0xff for every pixel that has to be forced to black.
+inline uint8x16_t DarkMaskNEON(const uint8x16x4_t& px, uint16x8_t t16) {
+  uint16x8_t sum_lo = vaddw_u8(vaddl_u8(vget_low_u8(px.val[0]), vget_low_u8(px.val[1])),
+                               vget_low_u8(px.val[2]));
+  uint16x8_t sum_hi = vaddw_u8(vaddl_u8(vget_high_u8(px.val[0]), vget_high_u8(px.val[1])),
+                               vget_high_u8(px.val[2]));
+  uint8x16_t dark_sum = vcombine_u8(vmovn_u16(vcltq_u16(sum_lo, t16)),
+                                    vmovn_u16(vcltq_u16(sum_hi, t16)));
+  uint16x8_t a_lo = vmovl_u8(vget_low_u8(px.val[3]));
+  uint16x8_t a_hi = vmovl_u8(vget_high_u8(px.val[3]));
+  uint8x16_t dark_alpha = vcombine_u8(vmovn_u16(vcltq_u16(a_lo, t16)),
+                                      vmovn_u16(vcltq_u16(a_hi, t16)));
+  return vorrq_u8(dark_sum, dark_alpha);
+}
+
+#if defined(__aarch64__)
+inline uint8x16_t LookupNEON(const uint8x16x4_t* table, uint8x16_t index) {
+  const uint8x16_t step = vdupq_n_u8(64);
+  uint8x16_t out = vqtbl4q_u8(table[0], index);
+  index = vsubq_u8(index, step);
+  out = vqtbx4q_u8(out, table[1], index);
+  index = vsubq_u8(index, step);
+  out = vqtbx4q_u8(out, table[2], index);
+  index = vsubq_u8(index, step);
+  return vqtbx4q_u8(out, table[3], index);
+}
+#endif
+
+void ConvertRowNEON(const uint8_t* gamma, int threshold, const uint8_t* rgba,
+                    uint8_t* rgb, int count) {
+  const uint16x8_t t16 = vdupq_n_u16(static_cast<uint16_t>(threshold));
+#if defined(__aarch64__)
+  uint8x16x4_t table[4];
+  for (int i = 0; i < 4; ++i) table[i] = vld1q_u8_x4(gamma + i * 64);
+#else
+  alignas(16) uint8_t premul[64];
+#endif
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x4_t px = vld4q_u8(rgba + i * 4);
+    uint8x16_t keep = vmvnq_u8(DarkMaskNEON(px, t16));
+    uint8x16x3_t out;
+    for (int c = 0; c < 3; ++c) {
+      out.val[c] = vandq_u8(PremultiplyNEON(px.val[c], px.val[3]), keep);
+    }
+#if defined(__aarch64__)
+    for (int c = 0; c < 3; ++c) out.val[c] = LookupNEON(table, out.val[c]);
+    vst3q_u8(rgb + i * 3, out);
+#else
+    uint8x16x4_t premul_px = {{out.val[0], out.val[1], out.val[2], px.val[3]}};
+    vst4q_u8(premul, premul_px);
+    LookupPremultiplied(gamma, premul, rgb + i * 3, 16);
+#endif
+  }
+  ConvertRowScalar(gamma, threshold, rgba + i * 4, rgb + i * 3, count - i);
+}
+
+#endif  // TRONBERRY_NEON_KERNELS
+
+const KernelTable<RowKernel, 4>& Kernels() {
+  static const KernelTable<RowKernel, 4> table = [] {
+    KernelTable<RowKernel, 4> table;
+    table.Add({"scalar", ConvertRowScalar});
+#if defined(TRONBERRY_X86_KERNELS)
+    if (__builtin_cpu_supports("ssse3")) table.Add({"ssse3", ConvertRowSSSE3});
+    if (__builtin_cpu_supports("avx2")) table.Add({"avx2", ConvertRowAVX2});
+#elif defined(TRONBERRY_NEON_KERNELS)
+    if (HasNEON()) table.Add({"neon", ConvertRowNEON});
+#endif
+    return table;
+  }();
+  return table;
+}
+
+}  // namespace
+
+const RowKernel& BestRowKernel() { return Kernels().best(); }
+
+int AvailableRowKernels(const RowKernel** kernels) { return Kernels().List(kernels); }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Row kernels for the no-floor color path: premultiply by alpha, force
+// pixels with alpha or r+g+b under |threshold| to black, and map every
+// channel through the 256-entry |gamma| table, writing packed RGB. Every
+// kernel must match ConvertRowScalar bit for bit.
+using RowKernelFn = void (*)(const uint8_t* gamma, int threshold,
+                             const uint8_t* rgba, uint8_t* rgb, int count);
+
+struct RowKernel {
+  const char* name;
+  RowKernelFn fn;
+};
+
+void ConvertRowScalar(const uint8_t* gamma, int threshold, const uint8_t* rgba,
+                      uint8_t* rgb, int count);
+
+// The fastest kernel supported by the CPU we are running on, picked once.
+const RowKernel& BestRowKernel();
+
+// Every kernel compiled in and supported at runtime, scalar first, so callers
+// can check the vector versions against the reference. Returns the count.
+int AvailableRowKernels(const RowKernel** kernels);
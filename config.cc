@@ -0,0 +1,108 @@
+#include "config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+template <typename T>
+void ParseValue(const std::string& key, const std::string& value, T* out) {
+  std::istringstream stream(value);
+  if (!(stream >> *out)) {
+    std::cerr << "Invalid " << key << " in config: " << value << std::endl;
+  }
+}
+
+void ParseMillis(const std::string& key, const std::string& value,
+                 std::chrono::milliseconds* out) {
+  long ms = 0;
+  ParseValue(key, value, &ms);
+  if (ms > 0) *out = std::chrono::milliseconds(ms);
+}
+
+// A size in MB, kept as bytes. Negative or unrepresentable sizes are
+// rejected and leave |out| as it was.
+void ParseMegabytes(const std::string& key, const std::string& value, size_t* out) {
+  long long mb = 0;
+  std::istringstream stream(value);
+  if (!(stream >> mb) || mb < 0 ||
+      static_cast<unsigned long long>(mb) > (SIZE_MAX >> 20)) {
+    std::cerr << "Invalid " << key << " in config: " << value << std::endl;
+    return;
+  }
+  *out = static_cast<size_t>(mb) << 20;
+}
+
+}  // namespace
+
+bool LoadConfig(const std::string& path, Config* config) {
+  std::ifstream file(path);
+  if (!file.is_open()) return false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    auto eq = line.find('=');
+    if (eq == std::string::npos) continue;
+    std::string key = line.substr(0, eq);
+    std::string value = line.substr(eq + 1);
+
+    if (key == "URL") {
+      config->url = value;
+    } else if (key == "PUSH_URL") {
+      config->push_url = value;
+    } else if (key == "CONNECT_TIMEOUT_MS") {
+      ParseMillis(key, value, &config->http.connect_timeout);
+    } else if (key == "READ_TIMEOUT_MS") {
+      ParseMillis(key, value, &config->http.read_timeout);
+    } else if (key == "WRITE_TIMEOUT_MS") {
+      ParseMillis(key, value, &config->http.write_timeout);
+    } else if (key == "GAMMA") {
+      ParseValue(key, value, &config->color.gamma);
+    } else if (key == "MIN_FLOOR") {
+      ParseValue(key, value, &config->color.min_floor);
+    } else if (key == "BRIGHTNESS_SCALE") {
+      ParseValue(key, value, &config->color.brightness);
+    } else if (key == "PRERENDER_MB") {
+      ParseMegabytes(key, value, &config->prerender_budget_bytes);
+    } else if (key == "CONTENT_CACHE_MB") {
+      ParseMegabytes(key, value, &config->content_cache_bytes);
+    } else if (key == "CACHE_DIR") {
+      config->cache_dir = value;
+    } else if (key == "TRANSITIONS") {
+      config->transitions_path = value;
+    } else if (key == "DISK_CACHE_MB") {
+      ParseMegabytes(key, value, &config->disk_cache_bytes);
+    } else if (key == "DISPLAY") {
+      config->display = value;
+    } else if (key == "DISPLAY_SIZE") {
+      int w = 0, h = 0;
+      if (sscanf(value.c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+        config->display_width = w;
+        config->display_height = h;
+      } else {
+        std::cerr << "Invalid " << key << " in config: " << value << std::endl;
+      }
+    } else if (key == "DUMP_DIR") {
+      config->dump_dir = value;
+    } else if (key == "DUMP_FORMAT") {
+      config->dump_format = value;
+    } else if (key == "CAPTURE") {
+      config->capture_path = value;
+    } else if (key == "REPLAY") {
+      config->replay_path = value;
+    } else if (key == "REPLAY_SPEED") {
+      ParseValue(key, value, &config->replay_speed);
+    } else if (key == "FETCH_CPU") {
+      ParseValue(key, value, &config->fetch_cpu);
+    } else if (key == "DECODE_CPU") {
+      ParseValue(key, value, &config->decode_cpu);
+    } else if (key == "RENDER_CPU") {
+      ParseValue(key, value, &config->render_cpu);
+    }
+  }
+  return true;
+}
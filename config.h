@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+#include "color.h"
+#include "http_client.h"
+
+// Settings read from tronberry.conf, one KEY=value per line.
+struct Config {
+  std::string url;
+  // WebSocket the server pushes apps on. Empty derives it from |url|,
+  // "off" sticks to polling.
+  std::string push_url;
+  HttpOptions http;
+  ColorParams color;
+  // Upper bound on memory spent on pre-rendered animation frames.
+  size_t prerender_budget_bytes = 32u << 20;
+  // Upper bound on decoded apps kept around for when they come back.
+  size_t content_cache_bytes = 64u << 20;
+  // Payloads kept on disk for warm restarts and outages; 0 disables.
+  std::string cache_dir = "cache";
+  size_t disk_cache_bytes = 16u << 20;
+  // JSON file of transition definitions; built-ins are used without one.
+  std::string transitions_path = "transitions.json";
+  // "matrix", or "offscreen" to run without a panel into a framebuffer of
+  // display_width x display_height, optionally dumping every frame shown
+  // into dump_dir as "ppm" or "raw" files.
+  std::string display = "matrix";
+  int display_width = 64;
+  int display_height = 32;
+  std::string dump_dir;
+  std::string dump_format = "ppm";
+  // Every response received is written to capture_path. With replay_path,
+  // responses come from that capture instead of the server, on a clock
+  // running replay_speed times as fast as real time (0: no waiting at all).
+  std::string capture_path;
+  std::string replay_path;
+  double replay_speed = 1;
+  // CPU each pipeline stage is pinned to; -1 leaves it to the scheduler.
+  int fetch_cpu = -1;
+  int decode_cpu = -1;
+  int render_cpu = -1;
+};
+
+// Reads |path| into |config|, keeping defaults for keys that are missing.
+// Returns false if the file cannot be opened.
+bool LoadConfig(const std::string& path, Config* config);
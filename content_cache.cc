@@ -0,0 +1,36 @@
+#include "content_cache.h"
+
+std::shared_ptr<const DecodedContent> ContentCache::Find(uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(hash);
+  if (it == index_.end()) return nullptr;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return *it->second;
+}
+
+bool ContentCache::Contains(uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.count(hash) != 0;
+}
+
+void ContentCache::Insert(std::shared_ptr<const DecodedContent> content) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(content->hash);
+  if (it != index_.end()) {
+    bytes_ -= (*it->second)->bytes();
+    lru_.erase(it->second);
+  }
+  bytes_ += content->bytes();
+  lru_.push_front(std::move(content));
+  index_[lru_.front()->hash] = lru_.begin();
+  EvictLocked();
+}
+
+void ContentCache::EvictLocked() {
+  // The newest entry always stays, even if it alone exceeds the budget.
+  while (bytes_ > byte_budget_ && lru_.size() > 1) {
+    bytes_ -= lru_.back()->bytes();
+    index_.erase(lru_.back()->hash);
+    lru_.pop_back();
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "frame_cache.h"
+#include "prerender.h"
+
+// 64-bit FNV-1a, usable incrementally: feed chunks through |hash|.
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+inline uint64_t Fnv1a64(const void* data, size_t len, uint64_t hash = kFnvOffset) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; ++i) {
+    hash = (hash ^ p[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+// One payload's panel-ready frames, shared read-only between the content
+// cache and whichever ring slot is showing it.
+struct DecodedContent {
+  uint64_t hash = 0;
+  bool still = false;
+  FrameCache frames;
+  PrerenderedAnimation prerendered;
+
+  size_t bytes() const { return frames.pixels.size() + prerendered.bytes(); }
+};
+
+// LRU of decoded payloads keyed by the hash of their WebP body, so an app
+// that comes around again in the rotation skips decoding, and with a
+// conditional GET, the download too. Shared by the fetch stage, which only
+// asks what is cached, and the decode stage, which fills it.
+class ContentCache {
+ public:
+  explicit ContentCache(size_t byte_budget) : byte_budget_(byte_budget) {}
+
+  std::shared_ptr<const DecodedContent> Find(uint64_t hash);
+  bool Contains(uint64_t hash);
+  void Insert(std::shared_ptr<const DecodedContent> content);
+
+ private:
+  using Entry = std::shared_ptr<const DecodedContent>;
+
+  void EvictLocked();
+
+  const size_t byte_budget_;
+  std::mutex mutex_;
+  std::list<Entry> lru_;  // most recent first
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+  size_t bytes_ = 0;
+};
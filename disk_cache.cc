@@ -0,0 +1,248 @@
+#include "disk_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "content_cache.h"
+#include "fetcher.h"
+
+namespace {
+
+constexpr const char* kIndexHeader = "tronberry-cache 1";
+constexpr std::chrono::minutes kIndexFlushInterval(1);
+
+bool WriteAll(int fd, const void* data, size_t len) {
+  const char* p = static_cast<const char*>(data);
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Writes |data| to |path| so that readers see either the old file or the
+// complete new one, never a torn write.
+bool WriteFileAtomically(const std::string& dir, const std::string& path,
+                         const void* data, size_t len) {
+  std::string tmp = path + ".tmp";
+  int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  bool ok = WriteAll(fd, data, len) && fsync(fd) == 0;
+  ok = close(fd) == 0 && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    unlink(tmp.c_str());
+    return false;
+  }
+  int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+  return true;
+}
+
+}  // namespace
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return nullptr;
+  return std::shared_ptr<const MappedFile>(
+      new MappedFile(static_cast<const uint8_t*>(addr), st.st_size));
+}
+
+MappedFile::~MappedFile() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+DiskCache::DiskCache(const std::string& dir, size_t byte_budget)
+    : dir_(dir), byte_budget_(byte_budget) {}
+
+DiskCache::~DiskCache() {
+  if (open_ && index_dirty_) WriteIndex();
+}
+
+bool DiskCache::Open() {
+  if (dir_.empty() || byte_budget_ == 0) return false;
+  if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "⚠️ Cannot create cache directory " << dir_ << std::endl;
+    return false;
+  }
+  open_ = true;
+
+  std::ifstream index(dir_ + "/index");
+  std::string line;
+  if (index.is_open() && std::getline(index, line) && line == kIndexHeader) {
+    while (std::getline(index, line)) {
+      Entry entry;
+      std::istringstream fields(line);
+      std::string hash_hex;
+      if (!(fields >> hash_hex >> entry.size >> entry.brightness >> entry.dwell_secs)) continue;
+      entry.hash = strtoull(hash_hex.c_str(), nullptr, 16);
+      if (Find(entry.hash)) continue;
+
+      auto mapped = MappedFile::Open(BodyPath(entry.hash));
+      if (!mapped || mapped->size() != entry.size ||
+          Fnv1a64(mapped->data(), mapped->size()) != entry.hash) {
+        continue;
+      }
+      entries_.push_back(entry);
+      bytes_ += entry.size;
+    }
+  }
+
+  // Drop bodies the index does not vouch for, and half-written temporaries.
+  if (DIR* dir = opendir(dir_.c_str())) {
+    while (dirent* ent = readdir(dir)) {
+      std::string name = ent->d_name;
+      if (name == "." || name == ".." || name == "index") continue;
+      bool keep = false;
+      if (name.size() == 16 + 5 && name.compare(16, 5, ".webp") == 0) {
+        keep = Find(strtoull(name.substr(0, 16).c_str(), nullptr, 16)) != nullptr;
+      }
+      if (!keep) unlink((dir_ + "/" + name).c_str());
+    }
+    closedir(dir);
+  }
+
+  Evict();
+  WriteIndex();
+  std::cout << "💾 Disk cache: " << entries_.size() << " payloads, " << bytes_
+            << " bytes in " << dir_ << std::endl;
+  return true;
+}
+
+bool DiskCache::Contains(uint64_t hash) const {
+  for (const Entry& entry : entries_) {
+    if (entry.hash == hash) return true;
+  }
+  return false;
+}
+
+void DiskCache::Store(const Payload& payload) {
+  if (!open_) return;
+  if (Entry* entry = Find(payload.hash)) {
+    entry->brightness = payload.brightness;
+    entry->dwell_secs = payload.dwell_secs;
+    MoveToBack(payload.hash);
+    MaybeWriteIndex();
+    return;
+  }
+
+  // The body goes down before the index that refers to it.
+  if (!WriteFileAtomically(dir_, BodyPath(payload.hash), payload.data(),
+                           payload.size())) {
+    std::cerr << "⚠️ Failed to write payload to disk cache\n";
+    return;
+  }
+  entries_.push_back({payload.hash, payload.size(), payload.brightness,
+                      payload.dwell_secs});
+  bytes_ += payload.size();
+  Evict();
+  WriteIndex();
+}
+
+void DiskCache::Touch(uint64_t hash) {
+  if (!open_ || !Find(hash)) return;
+  MoveToBack(hash);
+  MaybeWriteIndex();
+}
+
+bool DiskCache::Load(uint64_t hash, Payload* payload) {
+  Entry* entry = Find(hash);
+  return entry != nullptr && LoadEntry(*entry, payload);
+}
+
+bool DiskCache::Next(Payload* payload) {
+  for (size_t tries = 0; tries < entries_.size(); ++tries) {
+    const Entry& entry = entries_[replay_cursor_++ % entries_.size()];
+    if (LoadEntry(entry, payload)) {
+      payload->brightness = entry.brightness;
+      payload->dwell_secs = entry.dwell_secs;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string DiskCache::BodyPath(uint64_t hash) const {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016" PRIx64 ".webp", hash);
+  return dir_ + name;
+}
+
+DiskCache::Entry* DiskCache::Find(uint64_t hash) {
+  for (Entry& entry : entries_) {
+    if (entry.hash == hash) return &entry;
+  }
+  return nullptr;
+}
+
+void DiskCache::MoveToBack(uint64_t hash) {
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].hash == hash) {
+      Entry entry = entries_[i];
+      entries_.erase(entries_.begin() + i);
+      entries_.push_back(entry);
+      return;
+    }
+  }
+}
+
+bool DiskCache::LoadEntry(const Entry& entry, Payload* payload) {
+  auto mapped = MappedFile::Open(BodyPath(entry.hash));
+  if (!mapped || mapped->size() != entry.size) return false;
+  payload->body.clear();
+  payload->mapped = std::move(mapped);
+  payload->hash = entry.hash;
+  payload->not_modified = false;
+  return true;
+}
+
+void DiskCache::Evict() {
+  // The most recent entry always stays, even if it alone exceeds the budget.
+  while (bytes_ > byte_budget_ && entries_.size() > 1) {
+    unlink(BodyPath(entries_.front().hash).c_str());
+    bytes_ -= entries_.front().size;
+    entries_.erase(entries_.begin());
+  }
+}
+
+bool DiskCache::WriteIndex() {
+  std::string index = std::string(kIndexHeader) + "\n";
+  for (const Entry& entry : entries_) {
+    char line[96];
+    snprintf(line, sizeof(line), "%016" PRIx64 " %zu %d %d\n", entry.hash,
+             entry.size, entry.brightness, entry.dwell_secs);
+    index += line;
+  }
+  index_dirty_ = false;
+  index_written_ = std::chrono::steady_clock::now();
+  return WriteFileAtomically(dir_, dir_ + "/index", index.data(), index.size());
+}
+
+void DiskCache::MaybeWriteIndex() {
+  index_dirty_ = true;
+  if (std::chrono::steady_clock::now() - index_written_ >= kIndexFlushInterval) {
+    WriteIndex();
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  static std::shared_ptr<const MappedFile> Open(const std::string& path);
+  ~MappedFile();
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+struct Payload;
+
+// Recent payload bodies kept on disk, so that after a restart or while the
+// server is unreachable the panel can keep cycling the last rotation.
+//
+// Every body lives in <dir>/<hash>.webp and is mmapped when replayed. The
+// index lists the entries in the order they were last shown. Both are
+// written to a temporary file, fsynced and renamed into place, so an
+// unclean shutdown leaves either the old or the new version, and anything
+// the index does not vouch for (bad size, bad hash, stray files) is dropped
+// on startup. Reordering alone is flushed at most once a minute to spare
+// the SD card, and whatever is still pending when the cache is destroyed.
+// Entries are evicted least recently shown first once the bodies exceed the
+// byte budget. Not thread-safe; owned by the fetch stage.
+class DiskCache {
+ public:
+  DiskCache(const std::string& dir, size_t byte_budget);
+  ~DiskCache();
+
+  // Creates the directory and loads the index. Returns false if the cache
+  // cannot be used; the caller carries on without it.
+  bool Open();
+
+  bool empty() const { return entries_.empty(); }
+  bool Contains(uint64_t hash) const;
+
+  // Records |payload| as just shown, writing its body if it is new.
+  void Store(const Payload& payload);
+  // Marks |hash| as just shown.
+  void Touch(uint64_t hash);
+
+  // Maps the body of |hash| into |payload|.
+  bool Load(uint64_t hash, Payload* payload);
+  // Maps the next entry of the cached rotation into |payload|, cycling.
+  bool Next(Payload* payload);
+
+ private:
+  struct Entry {
+    uint64_t hash;
+    size_t size;
+    int brightness;
+    int dwell_secs;
+  };
+
+  std::string BodyPath(uint64_t hash) const;
+  Entry* Find(uint64_t hash);
+  void MoveToBack(uint64_t hash);
+  bool LoadEntry(const Entry& entry, Payload* payload);
+  void Evict();
+  bool WriteIndex();
+  void MaybeWriteIndex();
+
+  const std::string dir_;
+  const size_t byte_budget_;
+  bool open_ = false;
+  std::vector<Entry> entries_;  // least recently shown first
+  size_t bytes_ = 0;
+  size_t replay_cursor_ = 0;
+  bool index_dirty_ = false;
+  std::chrono::steady_clock::time_point index_written_;
+};
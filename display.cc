@@ -0,0 +1,99 @@
+#include "display.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+
+MatrixSink::MatrixSink(rgb_matrix::RGBMatrix* matrix)
+    : matrix_(matrix), canvas_(matrix->CreateFrameCanvas()) {}
+
+void MatrixSink::Blit(int x, int y, int width, int height, const uint8_t* rgb,
+                      int stride) {
+  BlitRGB(canvas_, x, y, width, height, rgb, stride);
+}
+
+bool MatrixSink::Load(const PrerenderedAnimation& frames, size_t index) {
+  return frames.Load(index, canvas_);
+}
+
+void MatrixSink::Swap() { canvas_ = matrix_->SwapOnVSync(canvas_); }
+
+void MatrixSink::SetBrightness(int percent) {
+  // The matrix sets it on the canvas showing, this on the one behind it.
+  matrix_->SetBrightness(percent);
+  canvas_->SetBrightness(percent);
+}
+
+rgb_matrix::FrameCanvas* MatrixSink::CreateScratch() {
+  return matrix_->CreateFrameCanvas();
+}
+
+OffscreenSink::OffscreenSink(int width, int height) {
+  front_.Resize(width, height);
+  back_.Resize(width, height);
+}
+
+bool OffscreenSink::DumpTo(const std::string& dir, DumpFormat format) {
+  mkdir(dir.c_str(), 0755);
+  struct stat st;
+  if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ||
+      access(dir.c_str(), W_OK | X_OK) != 0) {
+    return false;
+  }
+  dump_dir_ = dir;
+  dump_format_ = format;
+  return true;
+}
+
+void OffscreenSink::Blit(int x, int y, int width, int height, const uint8_t* rgb,
+                         int stride) {
+  const int x0 = std::max(x, 0);
+  const int y0 = std::max(y, 0);
+  const int x1 = std::min(x + width, back_.width);
+  const int y1 = std::min(y + height, back_.height);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  const int run = (x1 - x0) * 3;
+  const uint8_t* src = rgb + (y0 - y) * stride + (x0 - x) * 3;
+  for (int row = y0; row < y1; ++row, src += stride) {
+    uint8_t* dst = back_.row(row) + x0 * 3;
+    if (brightness_ >= 100) {
+      std::copy_n(src, run, dst);
+      continue;
+    }
+    for (int i = 0; i < run; ++i) dst[i] = src[i] * brightness_ / 100;
+  }
+}
+
+void OffscreenSink::Swap() {
+  std::swap(front_, back_);
+  if (!dump_dir_.empty()) Dump();
+  swaps_++;
+  if (on_swap_) on_swap_(front_);
+}
+
+void OffscreenSink::SetBrightness(int percent) {
+  brightness_ = std::clamp(percent, 0, 100);
+}
+
+void OffscreenSink::Dump() {
+  char name[32];
+  snprintf(name, sizeof(name), "/frame_%06llu.%s",
+           static_cast<unsigned long long>(swaps_),
+           dump_format_ == DumpFormat::kPPM ? "ppm" : "rgb");
+  const std::string path = dump_dir_ + name;
+  FILE* out = fopen(path.c_str(), "wb");
+  if (out == nullptr) {
+    std::cerr << "Cannot write " << path << std::endl;
+    dump_dir_.clear();
+    return;
+  }
+  if (dump_format_ == DumpFormat::kPPM) {
+    fprintf(out, "P6\n%d %d\n255\n", front_.width, front_.height);
+  }
+  fwrite(front_.pixels.data(), 1, front_.pixels.size(), out);
+  fclose(out);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+#include "blit.h"
+#include "led-matrix.h"
+#include "prerender.h"
+
+// Where the render stage puts its frames: the LED matrix, or an offscreen
+// framebuffer so the whole pipeline can run, and be profiled, on a machine
+// without one. Double buffered like the matrix: everything is drawn into
+// the back buffer and Swap shows it.
+class DisplaySink {
+ public:
+  virtual ~DisplaySink() = default;
+
+  virtual int width() const = 0;
+  virtual int height() const = 0;
+
+  // Writes a |width| x |height| packed RGB image whose rows are |stride|
+  // bytes apart into the back buffer at (x, y), clipped, at the current
+  // brightness.
+  virtual void Blit(int x, int y, int width, int height, const uint8_t* rgb,
+                    int stride) = 0;
+
+  // Copies pre-rendered frame |index| into the back buffer. Returns false if
+  // the sink cannot show them, in which case the caller blits the RGB frame.
+  virtual bool Load(const PrerenderedAnimation& frames, size_t index) { return false; }
+
+  // Shows the back buffer from the next refresh on. The buffer that was
+  // showing becomes the back buffer, with whatever it held.
+  virtual void Swap() = 0;
+
+  // Brightness in percent of everything written from now on, into either
+  // buffer. As on the panel, pixels already written keep theirs.
+  virtual void SetBrightness(int percent) = 0;
+
+  // A canvas that is never shown, for capturing frames in the panel's own
+  // format, or nullptr if the sink has none.
+  virtual rgb_matrix::FrameCanvas* CreateScratch() { return nullptr; }
+};
+
+inline void BlitFrame(DisplaySink* display, const RgbFrame& frame) {
+  display->Blit(0, 0, frame.width, frame.height, frame.pixels.data(),
+                frame.width * 3);
+}
+
+// The LED matrix through rpi-rgb-led-matrix. Swap waits for the vsync.
+class MatrixSink : public DisplaySink {
+ public:
+  explicit MatrixSink(rgb_matrix::RGBMatrix* matrix);
+
+  int width() const override { return canvas_->width(); }
+  int height() const override { return canvas_->height(); }
+  void Blit(int x, int y, int width, int height, const uint8_t* rgb,
+            int stride) override;
+  bool Load(const PrerenderedAnimation& frames, size_t index) override;
+  void Swap() override;
+  void SetBrightness(int percent) override;
+  rgb_matrix::FrameCanvas* CreateScratch() override;
+
+ private:
+  rgb_matrix::RGBMatrix* const matrix_;
+  rgb_matrix::FrameCanvas* canvas_;
+};
+
+enum class DumpFormat {
+  kPPM,  // binary PPM (P6), readable by most image tools
+  kRaw,  // bare packed RGB rows
+};
+
+// Two RGB framebuffers in memory. Brightness scales channels linearly as
+// they are written, as the matrix does with luminance correction off, and
+// Swap returns at once; pacing is left to the caller as with the panel.
+class OffscreenSink : public DisplaySink {
+ public:
+  OffscreenSink(int width, int height);
+
+  // Writes every frame shown from now on into |dir| as frame_000000.ppm
+  // (or .rgb), numbered by swap. Returns false if |dir| is not writable.
+  bool DumpTo(const std::string& dir, DumpFormat format);
+
+  // Called after every swap with the frame now showing.
+  void OnSwap(std::function<void(const RgbFrame& shown)> callback) {
+    on_swap_ = std::move(callback);
+  }
+
+  // Exactly the pixels showing, and how many frames have been shown.
+  const RgbFrame& shown() const { return front_; }
+  uint64_t swaps() const { return swaps_; }
+
+  int width() const override { return back_.width; }
+  int height() const override { return back_.height; }
+  void Blit(int x, int y, int width, int height, const uint8_t* rgb,
+            int stride) override;
+  void Swap() override;
+  void SetBrightness(int percent) override;
+
+ private:
+  void Dump();
+
+  RgbFrame front_;
+  RgbFrame back_;
+  int brightness_ = 100;
+  uint64_t swaps_ = 0;
+  std::string dump_dir_;
+  DumpFormat dump_format_ = DumpFormat::kPPM;
+  std::function<void(const RgbFrame&)> on_swap_;
+};
@@ -0,0 +1,281 @@
+#include "fetcher.h"
+
+#include <iostream>
+#include <sstream>
+
+#include "capture.h"
+#include "pipeline.h"
+#include "push_transport.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Enough to cover a typical rotation without bloating every request.
+constexpr size_t kMaxValidators = 32;
+
+// Requests between fetch timing summaries.
+constexpr uint64_t kStatsEvery = 50;
+
+}  // namespace
+
+FetchWorker::FetchWorker(const std::string& host, const std::string& path,
+                         const HttpOptions& http, PayloadRing* output,
+                         ContentCache* cache, DiskCache* disk,
+                         PushTransport* push, int cpu)
+    : host_(host),
+      path_(path),
+      output_(output),
+      cache_(cache),
+      disk_(disk),
+      push_(push),
+      cpu_(cpu),
+      client_(host, http) {}
+
+FetchWorker::~FetchWorker() { Stop(); }
+
+bool FetchWorker::Start() {
+  if (replay_ == nullptr && !client_.is_valid()) {
+    std::cerr << "Invalid client for: " << host_ << std::endl;
+    return false;
+  }
+  thread_ = std::thread(&FetchWorker::Run, this);
+  return true;
+}
+
+void FetchWorker::Stop() {
+  output_->Close();
+  client_.stop();
+  if (thread_.joinable()) thread_.join();
+}
+
+void FetchWorker::Run() {
+  SetCurrentThreadAffinity(cpu_, "fetch");
+  // Warm start: put the last rotation on the panel before the network is up.
+  bool warm_start = disk_ != nullptr && !disk_->empty();
+  while (Payload* slot = output_->WaitWrite()) {
+    // The decoder is done with whatever stream the slot last carried.
+    if (slot->stream != nullptr) {
+      streams_.Release(slot->stream);
+      slot->stream = nullptr;
+    }
+    if (replay_ != nullptr && replay_->done()) {
+      std::cout << "📼 Replay finished\n";
+      output_->Close();
+      return;
+    }
+    if (warm_start) {
+      warm_start = false;
+      if (disk_->Next(slot)) {
+        output_->CommitWrite();
+        continue;
+      }
+    }
+    if (push_ != nullptr && push_->connected()) {
+      // The slot still carries the dwell of the app it last held. If the
+      // server pushes nothing for that long, poll as if the socket were down
+      // rather than leaving the rotation on a silent socket.
+      if (Receive(slot, std::chrono::seconds(slot->dwell_secs))) {
+        output_->CommitWrite();
+        continue;
+      }
+    }
+    // Fetch publishes the slot itself, as early as it can.
+    if (Fetch(slot)) continue;
+    if (disk_ != nullptr && disk_->Next(slot)) {
+      std::cout << "📼 Server unreachable, replaying cached app\n";
+      output_->CommitWrite();
+      continue;
+    }
+    // A replay already has the time until the next attempt in it.
+    if (replay_ == nullptr) time_->SleepFor(1s);
+  }
+}
+
+bool FetchWorker::Fetch(Payload* payload) {
+  BodyStream* stream = nullptr;
+  Payload stored;  // what goes to the disk cache once the stream is done
+  FetchTiming timing;
+  CapturedResponse captured;  // only filled in when capturing
+  auto on_response = [&](const httplib::Response& response) {
+    if (capture_ != nullptr) {
+      captured.at = capture_->Now();
+      captured.status = response.status;
+      captured.headers = response.headers;
+    }
+    if (response.status != 200) return true;
+    stream = streams_.Acquire(response.get_header_value_u64("Content-Length"));
+    if (stream == nullptr) {
+      std::cerr << "⚠️ No free receive buffer\n";
+      return false;
+    }
+    // Publish now so the decode stage can start on the first bytes.
+    ParseHeaders(response, &stored);
+    payload->body.clear();
+    payload->mapped.reset();
+    payload->stream = stream;
+    payload->not_modified = false;
+    payload->brightness = stored.brightness;
+    payload->dwell_secs = stored.dwell_secs;
+    output_->CommitWrite();
+    return true;
+  };
+  auto on_body = [&](const char* data, size_t len) {
+    if (stream) stream->Append(data, len);
+    if (capture_ != nullptr) captured.body.append(data, len);
+    return true;
+  };
+  auto res = replay_ != nullptr
+                 ? replay_->Get(ConditionalHeaders(), on_response, on_body, &timing)
+                 : client_.Get(path_, ConditionalHeaders(), on_response, on_body, &timing);
+  if (capture_ != nullptr) {
+    if (captured.status == 0) captured.at = capture_->Now();
+    captured.ttfb = timing.ttfb;
+    captured.transfer = timing.transfer;
+    captured.error = res.error();
+    capture_->Write(captured);
+  }
+  if (res) {
+    timing.Report();
+    // A replay's timings are the recorded ones, already summed up live.
+    const FetchStats& stats = client_.stats();
+    if (replay_ == nullptr && stats.requests % kStatsEvery == 0) stats.Report();
+  }
+
+  if (stream) {
+    // The slot belongs to the decode stage from here on.
+    bool ok = res && res->status == 200;
+    stream->Finish(ok);
+    if (!ok) {
+      std::cerr << "Transfer from " << host_ << path_ << " was cut short" << std::endl;
+      return true;
+    }
+    stored.hash = stream->hash();
+    RememberValidators(*res, stored);
+    if (disk_ != nullptr) {
+      stored.stream = stream;
+      disk_->Store(stored);
+    }
+    return true;
+  }
+
+  if (!res || res->status != 304) {
+    std::cerr << "Failed to fetch from: " << host_ << path_ << std::endl;
+    return false;
+  }
+  Validator* validator = ResolveNotModified(*res, payload);
+  if (validator == nullptr) return false;
+  // Decoded frames may have been evicted while the body is still on disk.
+  if (disk_ != nullptr && !cache_->Contains(payload->hash)) {
+    disk_->Load(payload->hash, payload);
+  }
+  // The 304 only overrides what it actually sends.
+  ParseHeaders(*res, payload);
+  validator->brightness = payload->brightness;
+  validator->dwell_secs = payload->dwell_secs;
+  if (disk_ != nullptr) disk_->Touch(payload->hash);
+  output_->CommitWrite();
+  return true;
+}
+
+// Takes brightness and dwell from the tronbyt-brightness and
+// tronbyt-dwell-secs headers, leaving |payload|'s own where a header is
+// missing or invalid.
+void FetchWorker::ParseHeaders(const httplib::Response& res, Payload* payload) {
+  std::string brightness_header = res.get_header_value("tronbyt-brightness");
+  std::string dwell_header = res.get_header_value("tronbyt-dwell-secs");
+
+  if (!brightness_header.empty()) {
+    int brightness = 0;
+    std::istringstream brightness_stream(brightness_header);
+    if (!(brightness_stream >> brightness)) {
+      std::cerr << "Invalid brightness header: " << brightness_header << std::endl;
+    } else {
+      payload->brightness = std::clamp(brightness, 1, 50);
+    }
+  }
+
+  if (!dwell_header.empty()) {
+    int dwell_secs = 0;
+    std::istringstream dwell_stream(dwell_header);
+    if (!(dwell_stream >> dwell_secs)) {
+      std::cerr << "Invalid dwell header: " << dwell_header << std::endl;
+    } else {
+      payload->dwell_secs = std::max(dwell_secs, 1);
+    }
+  }
+}
+
+bool FetchWorker::Receive(Payload* payload, std::chrono::milliseconds timeout) {
+  if (!push_->Wait(payload, timeout)) return false;
+  payload->hash = Fnv1a64(payload->body.data(), payload->body.size());
+  if (disk_ != nullptr) disk_->Store(*payload);
+  return true;
+}
+
+bool FetchWorker::IsCached(uint64_t hash) {
+  return cache_->Contains(hash) || (disk_ != nullptr && disk_->Contains(hash));
+}
+
+httplib::Headers FetchWorker::ConditionalHeaders() {
+  httplib::Headers headers;
+  std::string etags;
+  for (const Validator& v : etags_) {
+    if (!IsCached(v.hash)) continue;
+    if (!etags.empty()) etags += ", ";
+    etags += v.value;
+  }
+  sent_if_modified_since_ = false;
+  if (!etags.empty()) {
+    headers.emplace("If-None-Match", etags);
+  } else if (!last_modified_.value.empty() && IsCached(last_modified_.hash)) {
+    headers.emplace("If-Modified-Since", last_modified_.value);
+    sent_if_modified_since_ = true;
+  }
+  return headers;
+}
+
+FetchWorker::Validator* FetchWorker::ResolveNotModified(const httplib::Response& res,
+                                                        Payload* payload) {
+  std::string etag = res.get_header_value("ETag");
+  Validator* found = nullptr;
+  if (!etag.empty()) {
+    for (Validator& v : etags_) {
+      if (v.value == etag) {
+        found = &v;
+        break;
+      }
+    }
+  } else if (sent_if_modified_since_) {
+    found = &last_modified_;
+  }
+  if (found == nullptr) {
+    std::cerr << "⚠️ 304 for content we do not know, refetching\n";
+    etags_.clear();
+    last_modified_ = Validator();
+    return nullptr;
+  }
+  payload->hash = found->hash;
+  payload->brightness = found->brightness;
+  payload->dwell_secs = found->dwell_secs;
+  payload->not_modified = true;
+  payload->body.clear();
+  payload->mapped.reset();
+  return found;
+}
+
+void FetchWorker::RememberValidators(const httplib::Response& res, const Payload& payload) {
+  std::string etag = res.get_header_value("ETag");
+  if (!etag.empty()) {
+    for (auto it = etags_.begin(); it != etags_.end(); ++it) {
+      if (it->value == etag) {
+        etags_.erase(it);
+        break;
+      }
+    }
+    etags_.push_back({etag, payload.hash, payload.brightness, payload.dwell_secs});
+    if (etags_.size() > kMaxValidators) etags_.pop_front();
+  }
+  last_modified_ = {res.get_header_value("Last-Modified"), payload.hash, payload.brightness,
+                    payload.dwell_secs};
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+
+#include "body_stream.h"
+#include "content_cache.h"
+#include "disk_cache.h"
+#include "http_client.h"
+#include "httplib.h"
+#include "spsc_ring.h"
+#include "time_source.h"
+
+class CaptureReplay;
+class CaptureWriter;
+class PushTransport;
+
+// One response from the Tronbyt server, ready to decode.
+struct Payload {
+  std::string body;  // empty when not_modified, |mapped| or |stream|
+  // Set instead of |body| when the payload is replayed from the disk cache.
+  std::shared_ptr<const MappedFile> mapped;
+  // Set instead of |body| for a fresh 200: the slot is published as soon as
+  // the headers are in and the body keeps arriving here. |hash| is filled in
+  // by the decode stage once the stream has finished. Borrowed from the
+  // fetch stage's pool until the slot is written again.
+  BodyStream* stream = nullptr;
+  uint64_t hash = 0;  // Fnv1a64 of the body
+  // The server answered 304: the body is the cached content with |hash|.
+  bool not_modified = false;
+  int brightness = 0;  // 0 when the server did not send tronbyt-brightness
+  int dwell_secs = 10;
+
+  const uint8_t* data() const {
+    if (stream) return stream->data();
+    return mapped ? mapped->data() : reinterpret_cast<const uint8_t*>(body.data());
+  }
+  size_t size() const {
+    if (stream) return stream->size();
+    return mapped ? mapped->size() : body.size();
+  }
+};
+
+// Single slot: every GET to /next advances the server's rotation, so the
+// fetch stage never runs more than one app ahead of the decoder.
+constexpr size_t kPayloadSlots = 1;
+using PayloadRing = SpscRing<Payload, kPayloadSlots>;
+
+// Network stage of the display pipeline. Fetches payloads on its own thread
+// and publishes them into |output| as soon as a slot is free, so the next
+// app is requested while the current one is still on the panel.
+//
+// Requests are conditional: the ETags of every body still in |cache| go out
+// in If-None-Match (or the last Last-Modified in If-Modified-Since when the
+// server sends no ETags), and a 304 is passed on as a not_modified payload
+// that the decode stage serves from the cache. A 200 is passed on as soon as
+// its headers arrive, with the body streaming in behind it.
+//
+// Every body is also written to |disk| (when given). At startup the first
+// app comes straight from there, and whenever the server cannot be reached
+// the worker keeps feeding the cached rotation instead of leaving the panel
+// on the same app.
+//
+// With a |push| transport (when given) the worker stops polling while the
+// socket is up and forwards whatever the server pushes instead. When nothing
+// is pushed for an app's dwell, it polls once for the next app.
+//
+// Polls reuse one kept-alive connection, and each one logs where its time
+// went (DNS, connect, TLS, time to first byte, transfer).
+class FetchWorker {
+ public:
+  FetchWorker(const std::string& host, const std::string& path,
+              const HttpOptions& http, PayloadRing* output, ContentCache* cache,
+              DiskCache* disk, PushTransport* push = nullptr, int cpu = -1);
+  ~FetchWorker();
+
+  // Before Start: write every response received into |capture|, or take
+  // the responses from |replay| instead of the server. A replay closes the
+  // output ring once it has run out.
+  void set_capture(CaptureWriter* capture) { capture_ = capture; }
+  void set_replay(CaptureReplay* replay) { replay_ = replay; }
+  // Before Start: wait out retries on |time|, the replay's clock if any.
+  void set_time(TimeSource* time) { time_ = time; }
+
+  // Returns false if |host| is not a usable URL.
+  bool Start();
+  void Stop();
+
+ private:
+  void Run();
+  bool Fetch(Payload* payload);
+  bool Receive(Payload* payload, std::chrono::milliseconds timeout);
+  void ParseHeaders(const httplib::Response& res, Payload* payload);
+  bool IsCached(uint64_t hash);
+  httplib::Headers ConditionalHeaders();
+  struct Validator {
+    std::string value;  // the ETag, or the Last-Modified date
+    uint64_t hash = 0;
+    // What the body was last served with, for a 304 that leaves them out.
+    int brightness = 0;
+    int dwell_secs = 10;
+  };
+
+  Validator* ResolveNotModified(const httplib::Response& res, Payload* payload);
+  void RememberValidators(const httplib::Response& res, const Payload& payload);
+
+  const std::string host_;
+  const std::string path_;
+  PayloadRing* const output_;
+  ContentCache* const cache_;
+  DiskCache* const disk_;
+  PushTransport* const push_;
+  CaptureWriter* capture_ = nullptr;
+  CaptureReplay* replay_ = nullptr;
+  TimeSource* time_ = SystemTime();
+  const int cpu_;
+  HttpClient client_;
+  std::thread thread_;
+  // One stream per ring slot plus the one being received.
+  BodyStreamPool streams_{kPayloadSlots + 1};
+
+  std::deque<Validator> etags_;  // oldest first
+  Validator last_modified_;      // empty value when the server sent none
+  bool sent_if_modified_since_ = false;
+};
@@ -0,0 +1,213 @@
+#include "frame_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <webp/decode.h>
+
+void FrameCache::Clear() {
+  width = 0;
+  height = 0;
+  pixels.clear();
+  durations_ms.clear();
+}
+
+bool DecodeStill(const WebPData& data, int duration_ms, FrameCache* cache) {
+  cache->Clear();
+
+  int width = 0, height = 0;
+  if (!WebPGetInfo(data.bytes, data.size, &width, &height)) {
+    std::cerr << "❌ Failed to decode static WebP image\n";
+    return false;
+  }
+  cache->width = width;
+  cache->height = height;
+  cache->pixels.resize(cache->frame_size());
+  if (!WebPDecodeRGBInto(data.bytes, data.size, cache->pixels.data(),
+                         cache->pixels.size(), width * 3)) {
+    std::cerr << "❌ Failed to decode static WebP image\n";
+    cache->Clear();
+    return false;
+  }
+  cache->durations_ms.push_back(duration_ms);
+  return true;
+}
+
+bool DecodeAnimation(const WebPData& data, const ColorPipeline& color,
+                     FrameCache* cache) {
+  cache->Clear();
+
+  WebPAnimDecoderOptions dec_options;
+  WebPAnimDecoderOptionsInit(&dec_options);
+  WebPAnimDecoder* decoder = WebPAnimDecoderNew(&data, &dec_options);
+  if (!decoder) {
+    std::cerr << "❌ Failed to create WebPAnimDecoder\n";
+    return false;
+  }
+
+  WebPAnimInfo anim_info;
+  if (!WebPAnimDecoderGetInfo(decoder, &anim_info)) {
+    std::cerr << "❌ Failed to get animation info from decoder\n";
+    WebPAnimDecoderDelete(decoder);
+    return false;
+  }
+
+  cache->width = anim_info.canvas_width;
+  cache->height = anim_info.canvas_height;
+  cache->pixels.reserve(anim_info.frame_count * cache->frame_size());
+  cache->durations_ms.reserve(anim_info.frame_count);
+
+  const int pixel_count = cache->width * cache->height;
+  uint8_t* frame;
+  int timestamp, last_timestamp = 0;
+
+  while (WebPAnimDecoderHasMoreFrames(decoder)) {
+    if (!WebPAnimDecoderGetNext(decoder, &frame, &timestamp)) {
+      std::cerr << "⚠️ Failed to get next frame\n";
+      break;
+    }
+
+    size_t offset = cache->pixels.size();
+    cache->pixels.resize(offset + cache->frame_size());
+
+    color.ConvertRow(frame, cache->pixels.data() + offset, pixel_count);
+
+    int delay = timestamp - last_timestamp;
+    cache->durations_ms.push_back(delay < 10 ? 10 : delay);
+    last_timestamp = timestamp;
+  }
+
+  WebPAnimDecoderDelete(decoder);
+  return cache->frame_count() > 0;
+}
+
+namespace {
+
+uint32_t Le24(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16; }
+uint32_t Le32(const uint8_t* p) { return Le24(p) | static_cast<uint32_t>(p[3]) << 24; }
+
+}  // namespace
+
+FirstFrameDecoder::~FirstFrameDecoder() {
+  if (decoder_ != nullptr) WebPIDelete(decoder_);
+}
+
+void FirstFrameDecoder::Reset() {
+  if (decoder_ != nullptr) WebPIDelete(decoder_);
+  decoder_ = nullptr;
+  state_ = State::kRiff;
+  header_.clear();
+  need_ = 12;
+  first_chunk_ = true;
+}
+
+void FirstFrameDecoder::Feed(const uint8_t* data, size_t len) {
+  while (len > 0 && wants_bytes()) {
+    const size_t n = std::min(len, need_ - header_.size());
+    if (state_ == State::kSkip) {
+      need_ -= n;
+      if (need_ == 0) Skip(0);
+    } else if (state_ == State::kFrame) {
+      need_ -= n;
+      VP8StatusCode status = WebPIAppend(decoder_, data, n);
+      if (status == VP8_STATUS_OK) {
+        Finish(State::kDone);
+      } else if (status != VP8_STATUS_SUSPENDED || need_ == 0) {
+        Finish(State::kFailed);
+      }
+    } else {
+      header_.insert(header_.end(), data, data + n);
+      if (header_.size() == need_) ParseHeader();
+    }
+    data += n;
+    len -= n;
+  }
+}
+
+// Acts on a complete RIFF header, chunk header or chunk prefix in |header_|.
+void FirstFrameDecoder::ParseHeader() {
+  const uint8_t* h = header_.data();
+  switch (state_) {
+    case State::kRiff:
+      if (memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WEBP", 4) != 0) {
+        return Finish(State::kFailed);
+      }
+      state_ = State::kChunkHeader;
+      need_ = 8;
+      break;
+    case State::kChunkHeader: {
+      const uint32_t size = Le32(h + 4);
+      const size_t padded = size + (size & 1);
+      // Only an extended file can be an animation, and it says so first.
+      if (first_chunk_ && memcmp(h, "VP8X", 4) != 0) return Finish(State::kFailed);
+      first_chunk_ = false;
+      if (memcmp(h, "VP8X", 4) == 0 && size >= 10) {
+        state_ = State::kVP8X;
+        need_ = 10;
+        rest_ = padded - 10;
+      } else if (memcmp(h, "ANMF", 4) == 0 && size > 16) {
+        state_ = State::kAnmf;
+        need_ = 16;
+        rest_ = size - 16;
+      } else if (memcmp(h, "ALPH", 4) == 0 || memcmp(h, "VP8 ", 4) == 0 ||
+                 memcmp(h, "VP8L", 4) == 0 || memcmp(h, "VP8X", 4) == 0 ||
+                 memcmp(h, "ANMF", 4) == 0) {
+        return Finish(State::kFailed);
+      } else {
+        Skip(padded);
+      }
+      break;
+    }
+    case State::kVP8X:
+      if (!(h[0] & ANIMATION_FLAG)) return Finish(State::kFailed);
+      canvas_width_ = 1 + Le24(h + 4);
+      canvas_height_ = 1 + Le24(h + 7);
+      Skip(rest_);
+      break;
+    case State::kAnmf: {
+      const int x = 2 * Le24(h);
+      const int y = 2 * Le24(h + 3);
+      const int width = 1 + Le24(h + 6);
+      const int height = 1 + Le24(h + 9);
+      duration_ms_ = Le24(h + 12);
+      if (x + width > canvas_width_ || y + height > canvas_height_) {
+        return Finish(State::kFailed);
+      }
+      const int stride = canvas_width_ * 4;
+      rgba_.assign(static_cast<size_t>(canvas_width_) * canvas_height_ * 4, 0);
+      const size_t origin = static_cast<size_t>(y) * stride + x * 4;
+      decoder_ = WebPINewRGB(MODE_RGBA, rgba_.data() + origin, rgba_.size() - origin, stride);
+      if (decoder_ == nullptr) return Finish(State::kFailed);
+      state_ = State::kFrame;
+      need_ = rest_;
+      break;
+    }
+    default:
+      break;
+  }
+  header_.clear();
+}
+
+// Passes over |len| payload bytes, then reads the next chunk header.
+void FirstFrameDecoder::Skip(size_t len) {
+  state_ = len > 0 ? State::kSkip : State::kChunkHeader;
+  need_ = len > 0 ? len : 8;
+}
+
+void FirstFrameDecoder::Finish(State state) {
+  state_ = state;
+  header_.clear();
+  if (decoder_ != nullptr) WebPIDelete(decoder_);
+  decoder_ = nullptr;
+}
+
+void FirstFrameDecoder::Take(const ColorPipeline& color, FrameCache* cache) const {
+  cache->Clear();
+  cache->width = canvas_width_;
+  cache->height = canvas_height_;
+  cache->pixels.resize(cache->frame_size());
+  color.ConvertRow(rgba_.data(), cache->pixels.data(), canvas_width_ * canvas_height_);
+  cache->durations_ms.push_back(duration_ms_ < 10 ? 10 : duration_ms_);
+}
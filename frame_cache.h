@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <webp/decode.h>
+#include <webp/demux.h>
+
+#include "color.h"
+
+// The frames of one payload, decoded once: every frame of an animation,
+// gamma-corrected through the colour pipeline, or a still as its single
+// frame of raw RGB (see DecodeStill). Frames are stored back to back as
+// packed RGB so the dwell loop can replay them straight from memory without
+// touching libwebp again.
+struct FrameCache {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+  std::vector<int> durations_ms;
+
+  size_t frame_count() const { return durations_ms.size(); }
+  size_t frame_size() const { return static_cast<size_t>(width) * height * 3; }
+  const uint8_t* frame(size_t index) const {
+    return pixels.data() + index * frame_size();
+  }
+
+  // Drops the frames but keeps the allocations for the next payload.
+  void Clear();
+};
+
+// Decodes a still image into |cache| as a single frame of raw RGB (stills
+// have never been gamma-corrected) shown for |duration_ms|.
+bool DecodeStill(const WebPData& data, int duration_ms, FrameCache* cache);
+
+// Decodes every frame of |data| into |cache| through |color|, replacing its
+// contents. Returns false if the payload is not a decodable animation.
+bool DecodeAnimation(const WebPData& data, const ColorPipeline& color,
+                     FrameCache* cache);
+
+// Decodes just the first frame of an animation whose bytes are still
+// arriving. Each byte is fed in once, as it lands: the container is walked
+// chunk header by chunk header and the frame's bitstream goes through
+// libwebp's incremental decoder, so nothing is parsed again as the body
+// grows. Keeps its buffers from one body to the next. Not thread-safe.
+class FirstFrameDecoder {
+ public:
+  FirstFrameDecoder() = default;
+  ~FirstFrameDecoder();
+
+  FirstFrameDecoder(const FirstFrameDecoder&) = delete;
+  FirstFrameDecoder& operator=(const FirstFrameDecoder&) = delete;
+
+  // Starts over for a new body.
+  void Reset();
+  // Takes the next |len| bytes of the body.
+  void Feed(const uint8_t* data, size_t len);
+
+  // False once more bytes cannot change the outcome: the frame is
+  // complete, or the body is a still or not a WebP.
+  bool wants_bytes() const { return state_ != State::kDone && state_ != State::kFailed; }
+  bool complete() const { return state_ == State::kDone; }
+
+  // Puts the complete first frame into |cache| through |color|, drawn over
+  // a transparent canvas exactly as WebPAnimDecoder would, so the full
+  // decode picks up seamlessly.
+  void Take(const ColorPipeline& color, FrameCache* cache) const;
+
+ private:
+  enum class State { kRiff, kChunkHeader, kVP8X, kAnmf, kFrame, kSkip, kDone, kFailed };
+
+  void ParseHeader();
+  void Skip(size_t len);
+  void Finish(State state);
+
+  State state_ = State::kRiff;
+  std::vector<uint8_t> header_;  // the header being collected
+  size_t need_ = 12;  // header bytes to collect, or payload bytes to go
+  size_t rest_ = 0;   // what follows the part of the chunk being collected
+  bool first_chunk_ = true;
+  int canvas_width_ = 0;
+  int canvas_height_ = 0;
+  int duration_ms_ = 0;
+  std::vector<uint8_t> rgba_;  // the canvas the frame is decoded onto
+  WebPIDecoder* decoder_ = nullptr;
+};
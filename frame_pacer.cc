@@ -0,0 +1,64 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Falling further behind than this (a stalled process, a suspended board)
+// restarts the schedule instead of racing through a backlog of frames.
+constexpr std::chrono::seconds kResyncThreshold(1);
+
+double Millis(std::chrono::nanoseconds ns) { return ns.count() / 1e6; }
+
+}  // namespace
+
+void PacingStats::Add(const PacingStats& other) {
+  frames += other.frames;
+  missed += other.missed;
+  dropped += other.dropped;
+  total_late += other.total_late;
+  max_late = std::max(max_late, other.max_late);
+}
+
+FramePacer::FramePacer(LatePolicy policy, TimeSource* time)
+    : policy_(policy), time_(time) {
+  Start();
+}
+
+void FramePacer::Start() { deadline_ = time_->Now(); }
+
+bool FramePacer::ShouldDrop(std::chrono::nanoseconds duration) {
+  if (policy_ != LatePolicy::kDropFrames) return false;
+  if (time_->Now() < deadline_ + duration) return false;
+  deadline_ += duration;
+  ++stats_.dropped;
+  return true;
+}
+
+void FramePacer::Wait(std::chrono::nanoseconds duration) {
+  deadline_ += duration;
+  ++stats_.frames;
+
+  auto now = time_->Now();
+  if (now < deadline_) {
+    time_->SleepUntil(deadline_);
+    return;
+  }
+
+  auto late = std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline_);
+  ++stats_.missed;
+  stats_.total_late += late;
+  if (late > stats_.max_late) stats_.max_late = late;
+  if (late > kResyncThreshold) deadline_ = now;
+}
+
+void FramePacer::Report(const char* label) const {
+  std::cout << "⏱️ " << label << ": " << stats_.frames << " frames, "
+            << stats_.missed << " missed";
+  if (stats_.missed > 0) {
+    std::cout << " (avg " << Millis(stats_.total_late) / stats_.missed
+              << " ms, max " << Millis(stats_.max_late) << " ms late)";
+  }
+  std::cout << ", " << stats_.dropped << " dropped\n";
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+
+#include "time_source.h"
+
+// What to do with frames whose whole display slot has already passed.
+enum class LatePolicy {
+  kShowAll,     // show every frame late and let the schedule catch up
+  kDropFrames,  // skip frames until we are back on the schedule
+};
+
+struct PacingStats {
+  uint64_t frames = 0;   // frames waited for
+  uint64_t missed = 0;   // frames that reached their deadline late
+  uint64_t dropped = 0;  // frames skipped under kDropFrames
+  std::chrono::nanoseconds total_late{0};
+  std::chrono::nanoseconds max_late{0};
+
+  // Folds |other| into these, as if both runs were one.
+  void Add(const PacingStats& other);
+};
+
+// Paces frames against absolute deadlines on |time|, the monotonic clock
+// unless given another. Each frame's deadline is the previous deadline plus
+// its duration, independent of how long conversion and SwapOnVSync took, so
+// time spent drawing is absorbed instead of added to every frame and long
+// animations keep their speed.
+//
+//   pacer.Start();
+//   for (each frame) {
+//     if (pacer.ShouldDrop(duration)) continue;
+//     draw; swap;
+//     pacer.Wait(duration);
+//   }
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FramePacer(LatePolicy policy = LatePolicy::kDropFrames,
+                      TimeSource* time = SystemTime());
+
+  // Starts the schedule now. Stats keep accumulating across restarts.
+  void Start();
+
+  // True if a frame lasting |duration| is already entirely in the past. The
+  // schedule advances past it and the caller should skip drawing it.
+  bool ShouldDrop(std::chrono::nanoseconds duration);
+
+  // Sleeps until the end of the frame that lasts |duration|.
+  void Wait(std::chrono::nanoseconds duration);
+
+  const PacingStats& stats() const { return stats_; }
+  void ResetStats() { stats_ = PacingStats(); }
+
+  // Logs a one-line summary of the stats under |label|.
+  void Report(const char* label) const;
+
+ private:
+  const LatePolicy policy_;
+  TimeSource* const time_;
+  Clock::time_point deadline_;
+  PacingStats stats_;
+};
@@ -0,0 +1,235 @@
+#include "http_client.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+using Clock = HttpClient::Clock;
+
+// Plain-HTTP client that notes when httplib's TCP connect has finished.
+class ConnectTimedClient : public httplib::ClientImpl {
+ public:
+  ConnectTimedClient(const std::string& host, int port, Clock::time_point* connected)
+      : httplib::ClientImpl(host, port), connected_(connected) {}
+
+ protected:
+  bool create_and_connect_socket(Socket& socket, httplib::Error& error) override {
+    bool ok = httplib::ClientImpl::create_and_connect_socket(socket, error);
+    *connected_ = Clock::now();
+    return ok;
+  }
+
+ private:
+  Clock::time_point* const connected_;
+};
+
+// Zero unless both marks were left and are in order.
+FetchTiming::Duration Between(Clock::time_point from, Clock::time_point to) {
+  if (from == Clock::time_point() || to <= from) return FetchTiming::Duration(0);
+  return std::chrono::duration_cast<FetchTiming::Duration>(to - from);
+}
+
+double Millis(FetchTiming::Duration d) { return d.count() / 1000.0; }
+
+bool IsNumericHost(const std::string& host) {
+  in6_addr addr;
+  return inet_pton(AF_INET, host.c_str(), &addr) == 1 ||
+         inet_pton(AF_INET6, host.c_str(), &addr) == 1;
+}
+
+}  // namespace
+
+void FetchTiming::Report() const {
+  std::cout << "🌐 Fetch: ";
+  if (reused) {
+    std::cout << "kept-alive";
+  } else {
+    std::cout << "dns " << Millis(dns) << " ms, connect " << Millis(connect) << " ms";
+    if (tls.count() > 0) {
+      std::cout << ", tls " << Millis(tls) << " ms" << (resumed ? " (resumed)" : "");
+    }
+  }
+  std::cout << ", ttfb " << Millis(ttfb) << " ms, transfer " << Millis(transfer)
+            << " ms, " << bytes / 1024 << " KB\n";
+}
+
+void FetchStats::Add(const FetchTiming& timing) {
+  requests++;
+  if (!timing.reused) connections++;
+  if (timing.resumed) resumed++;
+  total.dns += timing.dns;
+  total.connect += timing.connect;
+  total.tls += timing.tls;
+  total.ttfb += timing.ttfb;
+  total.transfer += timing.transfer;
+  total.bytes += timing.bytes;
+  max.dns = std::max(max.dns, timing.dns);
+  max.connect = std::max(max.connect, timing.connect);
+  max.tls = std::max(max.tls, timing.tls);
+  max.ttfb = std::max(max.ttfb, timing.ttfb);
+  max.transfer = std::max(max.transfer, timing.transfer);
+  max.bytes = std::max(max.bytes, timing.bytes);
+}
+
+void FetchStats::Report() const {
+  if (requests == 0) return;
+  // Connection phases average over the requests that had them.
+  uint64_t opened = std::max<uint64_t>(connections, 1);
+  std::cout << "🌐 Fetch stats: " << requests << " requests, " << connections
+            << " connections (" << resumed << " resumed); avg/max ms: dns "
+            << Millis(total.dns) / opened << "/" << Millis(max.dns) << ", connect "
+            << Millis(total.connect) / opened << "/" << Millis(max.connect) << ", tls "
+            << Millis(total.tls) / opened << "/" << Millis(max.tls) << ", ttfb "
+            << Millis(total.ttfb) / requests << "/" << Millis(max.ttfb) << ", transfer "
+            << Millis(total.transfer) / requests << "/" << Millis(max.transfer) << "\n";
+}
+
+HttpClient::HttpClient(const std::string& origin, const HttpOptions& options) {
+  std::string rest = origin;
+  if (rest.starts_with("https://")) {
+    tls_ = true;
+    rest = rest.substr(8);
+  } else if (rest.starts_with("http://")) {
+    rest = rest.substr(7);
+  }
+  port_ = tls_ ? 443 : 80;
+  auto colon = rest.rfind(':');
+  if (colon != std::string::npos && rest.find(']', colon) == std::string::npos) {
+    port_ = atoi(rest.c_str() + colon + 1);
+    rest.resize(colon);
+  }
+  if (rest.size() > 2 && rest.front() == '[' && rest.back() == ']') {
+    rest = rest.substr(1, rest.size() - 2);
+  }
+  host_ = rest;
+
+  if (tls_) {
+    auto ssl = std::make_unique<httplib::SSLClient>(host_, port_);
+    SSL_CTX* ctx = ssl->ssl_context();
+    if (ctx != nullptr) {
+      SSL_CTX_set_app_data(ctx, this);
+      SSL_CTX_set_session_cache_mode(
+          ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+      SSL_CTX_sess_set_new_cb(ctx, &HttpClient::OnNewSession);
+      SSL_CTX_set_info_callback(ctx, &HttpClient::OnHandshakeInfo);
+    }
+    ssl->set_ssl_setup_callback([this](SSL* conn) {
+      if (session_ != nullptr) SSL_set_session(conn, session_);
+    });
+    client_ = std::move(ssl);
+  } else {
+    client_ = std::make_unique<ConnectTimedClient>(host_, port_, &connect_end_);
+  }
+
+  client_->set_keep_alive(true);
+  client_->set_connection_timeout(options.connect_timeout);
+  client_->set_read_timeout(options.read_timeout);
+  client_->set_write_timeout(options.write_timeout);
+  client_->set_socket_options([this](socket_t sock) {
+    connect_start_ = Clock::now();
+    httplib::default_socket_options(sock);
+  });
+}
+
+HttpClient::~HttpClient() {
+  client_.reset();
+  if (session_ != nullptr) SSL_SESSION_free(session_);
+}
+
+bool HttpClient::is_valid() const { return !host_.empty() && client_->is_valid(); }
+
+void HttpClient::stop() { client_->stop(); }
+
+httplib::Result HttpClient::Get(const std::string& path, const httplib::Headers& headers,
+                                httplib::ResponseHandler on_response,
+                                httplib::ContentReceiver on_body, FetchTiming* timing) {
+  *timing = FetchTiming();
+  if (!client_->is_socket_open()) Resolve(timing);
+
+  connect_start_ = connect_end_ = tls_end_ = Clock::time_point();
+  handshaking_ = false;
+  resumed_ = false;
+  Clock::time_point sent = Clock::now();
+  Clock::time_point headers_in;
+  auto res = client_->Get(
+      path, headers,
+      [&](const httplib::Response& response) {
+        headers_in = Clock::now();
+        return on_response(response);
+      },
+      [&](const char* data, size_t len) {
+        timing->bytes += len;
+        return on_body(data, len);
+      });
+  Clock::time_point done = Clock::now();
+
+  timing->reused = connect_start_ == Clock::time_point();
+  if (!timing->reused) {
+    timing->connect = Between(connect_start_, connect_end_);
+    sent = connect_end_;
+    if (tls_) {
+      timing->tls = Between(connect_end_, tls_end_);
+      timing->resumed = resumed_;
+      sent = tls_end_;
+    }
+  }
+  timing->ttfb = Between(sent, headers_in);
+  timing->transfer = Between(headers_in, done);
+  if (res) stats_.Add(*timing);
+  return res;
+}
+
+// Pins the server's address so httplib's own lookup is a no-op and the
+// time spent in DNS is ours to measure. Only done before a new connection.
+void HttpClient::Resolve(FetchTiming* timing) {
+  if (IsNumericHost(host_)) return;
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  Clock::time_point start = Clock::now();
+  int err = getaddrinfo(host_.c_str(), nullptr, &hints, &result);
+  timing->dns = Between(start, Clock::now());
+  if (err != 0) {
+    std::cerr << "DNS lookup for " << host_ << " failed: " << gai_strerror(err) << std::endl;
+    return;
+  }
+
+  char ip[INET6_ADDRSTRLEN] = {};
+  const void* addr =
+      result->ai_family == AF_INET6
+          ? static_cast<const void*>(&reinterpret_cast<sockaddr_in6*>(result->ai_addr)->sin6_addr)
+          : static_cast<const void*>(&reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr);
+  if (inet_ntop(result->ai_family, addr, ip, sizeof(ip)) != nullptr) {
+    client_->set_hostname_addr_map({{host_, ip}});
+  }
+  freeaddrinfo(result);
+}
+
+int HttpClient::OnNewSession(SSL* ssl, SSL_SESSION* session) {
+  auto* self = static_cast<HttpClient*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  if (self->session_ != nullptr) SSL_SESSION_free(self->session_);
+  self->session_ = session;
+  return 1;  // we keep the reference
+}
+
+void HttpClient::OnHandshakeInfo(const SSL* ssl, int where, int ret) {
+  auto* self = static_cast<HttpClient*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  if ((where & SSL_CB_HANDSHAKE_START) && !self->handshaking_) {
+    self->handshaking_ = true;
+    self->connect_end_ = Clock::now();
+  }
+  if ((where & SSL_CB_HANDSHAKE_DONE) && self->handshaking_) {
+    self->handshaking_ = false;
+    self->tls_end_ = Clock::now();
+    self->resumed_ = SSL_session_reused(ssl);
+  }
+}
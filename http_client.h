@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "httplib.h"
+
+struct HttpOptions {
+  std::chrono::milliseconds connect_timeout{5000};
+  std::chrono::milliseconds read_timeout{15000};
+  std::chrono::milliseconds write_timeout{5000};
+};
+
+// Where the time of one request went. Phases the request did not go through
+// are zero: a kept-alive connection skips DNS, connect and TLS.
+struct FetchTiming {
+  using Duration = std::chrono::microseconds;
+  Duration dns{0};
+  Duration connect{0};
+  Duration tls{0};
+  Duration ttfb{0};      // request sent to response headers in
+  Duration transfer{0};  // response headers to last body byte
+  bool reused = false;   // went out on a kept-alive connection
+  bool resumed = false;  // the TLS handshake resumed a cached session
+  size_t bytes = 0;
+
+  // Logs a one-line breakdown.
+  void Report() const;
+};
+
+// Running totals over every request, so a slow access point shows up as a
+// pattern rather than one unlucky fetch.
+struct FetchStats {
+  uint64_t requests = 0;
+  uint64_t connections = 0;  // requests that had to open a connection
+  uint64_t resumed = 0;
+  FetchTiming total;
+  FetchTiming max;
+
+  void Add(const FetchTiming& timing);
+  // Logs per-phase averages and maxima.
+  void Report() const;
+};
+
+// Keep-alive HTTP(S) client for the Tronbyt server that times every phase
+// of each request. httplib does its own DNS, connect and handshake, so the
+// phases are taken from the outside: DNS is resolved here and pinned with
+// set_hostname_addr_map, the connect starts in the socket-options hook and
+// ends when the TLS handshake starts (or, for plain HTTP, when httplib's
+// connect returns), and the handshake is bracketed by OpenSSL's info
+// callback. The last session is offered back to the server before each
+// new handshake, so reconnects after an idle close resume instead of doing
+// a full one. Not thread-safe; owned by the fetch stage.
+class HttpClient {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // |origin| is scheme://host[:port], as split off the configured URL.
+  HttpClient(const std::string& origin, const HttpOptions& options);
+  ~HttpClient();
+
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+
+  bool is_valid() const;
+
+  // httplib's streaming Get, plus the breakdown of where its time went.
+  httplib::Result Get(const std::string& path, const httplib::Headers& headers,
+                      httplib::ResponseHandler on_response,
+                      httplib::ContentReceiver on_body, FetchTiming* timing);
+
+  // Aborts a request in flight from another thread.
+  void stop();
+
+  // Totals over every request that got a response.
+  const FetchStats& stats() const { return stats_; }
+
+ private:
+  void Resolve(FetchTiming* timing);
+  static int OnNewSession(SSL* ssl, SSL_SESSION* session);
+  static void OnHandshakeInfo(const SSL* ssl, int where, int ret);
+
+  bool tls_ = false;
+  std::string host_;
+  int port_ = 0;
+  std::unique_ptr<httplib::ClientImpl> client_;
+  SSL_SESSION* session_ = nullptr;
+  FetchStats stats_;
+
+  // Left by httplib's callbacks during Get(), on the calling thread.
+  Clock::time_point connect_start_;
+  Clock::time_point connect_end_;
+  Clock::time_point tls_end_;
+  bool handshaking_ = false;
+  bool resumed_ = false;
+};
@@ -4,6 +4,8 @@
 //  Copyright (c) 2025 Yuji Hirose. All rights reserved.
 //  MIT License
 //
+//  Patched for tronberry with httplib-ssl-setup.patch, see README.md.
+//
 
 #ifndef CPPHTTPLIB_HTTPLIB_H
 #define CPPHTTPLIB_HTTPLIB_H
@@ -2003,6 +2005,10 @@ public:
 
   SSL_CTX *ssl_context() const;
 
+  // Called on each new connection's SSL after SNI is set and before
+  // SSL_connect, e.g. to offer a cached session with SSL_set_session.
+  void set_ssl_setup_callback(std::function<void(SSL *ssl)> callback);
+
 private:
   bool create_and_connect_socket(Socket &socket, Error &error) override;
   void shutdown_ssl(Socket &socket, bool shutdown_gracefully) override;
@@ -2035,6 +2041,8 @@ private:
 
   long verify_result_ = 0;
 
+  std::function<void(SSL *ssl)> ssl_setup_callback_;
+
   friend class ClientImpl;
 };
 #endif
@@ -9658,6 +9666,11 @@ inline bool SSLClient::load_certs() {
   return ret;
 }
 
+inline void
+SSLClient::set_ssl_setup_callback(std::function<void(SSL *ssl)> callback) {
+  ssl_setup_callback_ = std::move(callback);
+}
+
 inline bool SSLClient::initialize_ssl(Socket &socket, Error &error) {
   auto ssl = detail::ssl_new(
       socket.sock, ctx_, ctx_mutex_,
@@ -9725,6 +9738,7 @@ inline bool SSLClient::initialize_ssl(Socket &socket, Error &error) {
         SSL_ctrl(ssl2, SSL_CTRL_SET_TLSEXT_HOSTNAME, TLSEXT_NAMETYPE_host_name,
                  static_cast<void *>(const_cast<char *>(host_.c_str())));
 #endif
+        if (ssl_setup_callback_) { ssl_setup_callback_(ssl2); }
         return true;
       });
 
@@ -0,0 +1,294 @@
+// Stand-in for a Tronbyt server, for measuring how tronberry copes with a
+// slow or flaky network without a real one. Every GET to the path serves
+// the next WebP of the rotation with its tronbyt-dwell-secs and
+// tronbyt-brightness headers, after whatever faults are configured:
+//
+//   ./mock_server [options] app.webp[:dwell[:brightness]]...
+//
+//   --port N        port to listen on (default 8000)
+//   --path P        path serving the rotation (default /next)
+//   --dwell N       dwell for apps that set none (default 10)
+//   --brightness N  brightness for apps that set none (default: no header)
+//   --latency-ms N  delay before the response headers
+//   --jitter-ms N   plus up to N ms more, at random
+//   --kbps N        cap each body at N KiB/s
+//   --error-rate P  answer P percent of requests with a 503
+//   --stall-rate P  stop P percent of bodies halfway through for --stall-ms
+//   --stall-ms N    (default 30000, past tronberry's read timeout)
+//   --no-etag       send no ETags, so nothing is ever answered with a 304
+//   --seed N        seed for the faults, to repeat a run
+//
+// Point URL in tronberry.conf at http://<this host>:<port><path>. Each
+// request is logged with the time since the one before, which is how long
+// tronberry took to switch apps, or to come back after a fault.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "content_cache.h"
+#include "httplib.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct App {
+  std::string path;
+  std::string body;
+  std::string etag;
+  int dwell_secs = 0;
+  int brightness = 0;
+};
+
+struct Options {
+  int port = 8000;
+  std::string path = "/next";
+  int dwell_secs = 10;
+  int brightness = 0;
+  int latency_ms = 0;
+  int jitter_ms = 0;
+  int kbps = 0;
+  int error_rate = 0;
+  int stall_rate = 0;
+  int stall_ms = 30000;
+  bool etags = true;
+  unsigned seed = 1;
+};
+
+// Requests between summaries.
+constexpr uint64_t kStatsEvery = 20;
+
+// How often a capped body is topped up.
+constexpr auto kTick = std::chrono::milliseconds(50);
+
+// What happens to one request, decided up front under the lock.
+struct Plan {
+  const App* app;
+  uint64_t request;
+  double gap_ms;  // since the previous request
+  std::chrono::milliseconds latency{0};
+  bool error = false;
+  bool stall = false;
+};
+
+class MockServer {
+ public:
+  MockServer(const Options& options, std::vector<App> apps)
+      : options_(options), apps_(std::move(apps)), rng_(options.seed) {}
+
+  bool Listen() {
+    server_.Get(options_.path, [this](const httplib::Request& req, httplib::Response& res) {
+      Serve(req, res);
+    });
+    std::cout << "Serving " << apps_.size() << " apps at http://0.0.0.0:" << options_.port
+              << options_.path << std::endl;
+    return server_.listen("0.0.0.0", options_.port);
+  }
+
+ private:
+  Plan Next() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Plan plan;
+    plan.app = &apps_[next_app_];
+    plan.request = ++requests_;
+    const Clock::time_point now = Clock::now();
+    plan.gap_ms = requests_ == 1 ? 0 : std::chrono::duration<double, std::milli>(
+                                           now - last_request_).count();
+    last_request_ = now;
+
+    std::uniform_int_distribution<int> percent(0, 99);
+    plan.error = percent(rng_) < options_.error_rate;
+    plan.stall = !plan.error && percent(rng_) < options_.stall_rate;
+    int latency = options_.latency_ms;
+    if (options_.jitter_ms > 0) {
+      latency += std::uniform_int_distribution<int>(0, options_.jitter_ms)(rng_);
+    }
+    plan.latency = std::chrono::milliseconds(latency);
+    // A failed request does not advance the rotation, as on the real server.
+    if (!plan.error) next_app_ = (next_app_ + 1) % apps_.size();
+    return plan;
+  }
+
+  void Serve(const httplib::Request& req, httplib::Response& res) {
+    const Plan plan = Next();
+    std::this_thread::sleep_for(plan.latency);
+
+    const App& app = *plan.app;
+    const char* result;
+    if (plan.error) {
+      res.status = httplib::StatusCode::ServiceUnavailable_503;
+      result = "503";
+    } else {
+      res.set_header("tronbyt-dwell-secs", std::to_string(app.dwell_secs));
+      if (app.brightness > 0) {
+        res.set_header("tronbyt-brightness", std::to_string(app.brightness));
+      }
+      if (options_.etags) res.set_header("ETag", app.etag);
+      if (options_.etags &&
+          req.get_header_value("If-None-Match").find(app.etag) != std::string::npos) {
+        res.status = httplib::StatusCode::NotModified_304;
+        result = "304";
+      } else {
+        SendBody(app, plan.stall, res);
+        result = plan.stall ? "200 stalled" : "200";
+      }
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "#%-5llu +%8.1f ms  %-12s %s (%zu bytes, latency %lld ms)",
+             static_cast<unsigned long long>(plan.request), plan.gap_ms, result,
+             app.path.c_str(), app.body.size(),
+             static_cast<long long>(plan.latency.count()));
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << line << std::endl;
+    counts_[plan.error ? 2 : res.status == 304 ? 1 : 0]++;
+    if (plan.stall) stalls_++;
+    if (plan.request % kStatsEvery == 0) {
+      std::cout << "📊 " << plan.request << " requests: " << counts_[0] << " bodies, "
+                << counts_[1] << " not modified, " << counts_[2] << " errors, " << stalls_
+                << " stalls" << std::endl;
+    }
+  }
+
+  // Streams the body |options_.kbps| at a time per second, stopping for
+  // |stall_ms| halfway through if |stall|.
+  void SendBody(const App& app, bool stall, httplib::Response& res) {
+    const size_t chunk =
+        options_.kbps > 0 ? std::max<size_t>(options_.kbps * 1024 * kTick.count() / 1000, 1)
+                          : app.body.size();
+    const auto stall_for = std::chrono::milliseconds(options_.stall_ms);
+    res.set_content_provider(
+        app.body.size(), "image/webp",
+        [&app, chunk, stall, stall_for](size_t offset, size_t length,
+                                        httplib::DataSink& sink) {
+          const size_t half = app.body.size() / 2;
+          size_t n = std::min(length, chunk);
+          if (stall && offset < half) n = std::min(n, half - offset);
+          if (stall && offset == half) std::this_thread::sleep_for(stall_for);
+          if (!sink.write(app.body.data() + offset, n)) return false;
+          if (chunk < app.body.size()) std::this_thread::sleep_for(kTick);
+          return true;
+        });
+  }
+
+  const Options options_;
+  const std::vector<App> apps_;
+  httplib::Server server_;
+
+  std::mutex mutex_;
+  std::mt19937 rng_;
+  size_t next_app_ = 0;
+  uint64_t requests_ = 0;
+  Clock::time_point last_request_;
+  uint64_t counts_[3] = {};  // bodies, not modified, errors
+  uint64_t stalls_ = 0;
+};
+
+bool ReadFile(const std::string& path, std::string* out) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  *out = contents.str();
+  return true;
+}
+
+// app.webp[:dwell[:brightness]]
+bool LoadApp(const std::string& spec, const Options& options, App* app) {
+  app->dwell_secs = options.dwell_secs;
+  app->brightness = options.brightness;
+  const size_t colon = spec.find(':');
+  app->path = spec.substr(0, colon);
+  if (colon != std::string::npos &&
+      sscanf(spec.c_str() + colon + 1, "%d:%d", &app->dwell_secs, &app->brightness) < 1) {
+    std::cerr << "Invalid app: " << spec << std::endl;
+    return false;
+  }
+  if (!ReadFile(app->path, &app->body) || app->body.empty()) {
+    std::cerr << "Cannot read " << app->path << std::endl;
+    return false;
+  }
+  char etag[24];
+  snprintf(etag, sizeof(etag), "\"%016llx\"",
+           static_cast<unsigned long long>(Fnv1a64(app->body.data(), app->body.size())));
+  app->etag = etag;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  std::vector<std::string> specs;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    auto number = [&](int* out) {
+      if (value == nullptr) return false;
+      *out = atoi(value);
+      ++i;
+      return true;
+    };
+    bool ok = true;
+    if (strcmp(arg, "--port") == 0) {
+      ok = number(&options.port);
+    } else if (strcmp(arg, "--path") == 0 && value != nullptr) {
+      options.path = argv[++i];
+    } else if (strcmp(arg, "--dwell") == 0) {
+      ok = number(&options.dwell_secs);
+    } else if (strcmp(arg, "--brightness") == 0) {
+      ok = number(&options.brightness);
+    } else if (strcmp(arg, "--latency-ms") == 0) {
+      ok = number(&options.latency_ms);
+    } else if (strcmp(arg, "--jitter-ms") == 0) {
+      ok = number(&options.jitter_ms);
+    } else if (strcmp(arg, "--kbps") == 0) {
+      ok = number(&options.kbps);
+    } else if (strcmp(arg, "--error-rate") == 0) {
+      ok = number(&options.error_rate);
+    } else if (strcmp(arg, "--stall-rate") == 0) {
+      ok = number(&options.stall_rate);
+    } else if (strcmp(arg, "--stall-ms") == 0) {
+      ok = number(&options.stall_ms);
+    } else if (strcmp(arg, "--no-etag") == 0) {
+      options.etags = false;
+    } else if (strcmp(arg, "--seed") == 0) {
+      int seed = 0;
+      ok = number(&seed);
+      options.seed = seed;
+    } else if (arg[0] == '-') {
+      ok = false;
+    } else {
+      specs.push_back(arg);
+    }
+    if (!ok) {
+      std::cerr << "Invalid option: " << arg << std::endl;
+      return 1;
+    }
+  }
+  if (specs.empty()) {
+    std::cerr << "Usage: mock_server [options] app.webp[:dwell[:brightness]]..." << std::endl;
+    return 1;
+  }
+
+  std::vector<App> apps(specs.size());
+  for (size_t i = 0; i < specs.size(); ++i) {
+    if (!LoadApp(specs[i], options, &apps[i])) return 1;
+  }
+  MockServer server(options, std::move(apps));
+  if (!server.Listen()) {
+    std::cerr << "Cannot listen on port " << options.port << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include "particles.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <array>
+
+#include "polar_map.h"
+
+namespace {
+
+constexpr int kTrigBits = 10;
+constexpr int kTrigSteps = 1 << kTrigBits;
+
+const std::array<int16_t, kTrigSteps>& SineTable() {
+  static const std::array<int16_t, kTrigSteps> table = [] {
+    std::array<int16_t, kTrigSteps> t;
+    for (int i = 0; i < kTrigSteps; ++i) {
+      t[i] = static_cast<int16_t>(lround(sin(2 * M_PI * i / kTrigSteps) * 16384));
+    }
+    return t;
+  }();
+  return table;
+}
+
+}  // namespace
+
+int FixedSin(uint32_t angle) { return SineTable()[angle >> (32 - kTrigBits)]; }
+
+int FixedCos(uint32_t angle) { return FixedSin(angle + (1u << 30)); }
+
+void SpriteSheet::BuildDot(int radius, int hues) {
+  size_ = radius * 2 + 1;
+  hues_ = hues;
+  const int area = size_ * size_;
+  const int falloff = radius * 2 + 2;
+  std::vector<int> weight(area);
+  for (int dy = -radius, i = 0; dy <= radius; ++dy) {
+    for (int dx = -radius; dx <= radius; ++dx, ++i) {
+      weight[i] = falloff - abs(dx) - abs(dy);
+    }
+  }
+
+  stamps_.resize(static_cast<size_t>(hues) * area * 3);
+  uint8_t* out = stamps_.data();
+  for (int h = 0; h < hues; ++h) {
+    uint8_t rgb[3];
+    HueToRGB(h * kHueSteps / hues, rgb);
+    for (int i = 0; i < area; ++i, out += 3) {
+      out[0] = rgb[0] * weight[i] / falloff;
+      out[1] = rgb[1] * weight[i] / falloff;
+      out[2] = rgb[2] * weight[i] / falloff;
+    }
+  }
+}
+
+void ParticleField::Resize(size_t count) {
+  x.resize(count);
+  y.resize(count);
+  hue.resize(count);
+}
+
+void ParticleField::Render(const SpriteSheet& sheet, RgbFrame* image) const {
+  const int size = sheet.size();
+  const int radius = sheet.radius();
+  for (size_t i = 0; i < x.size(); ++i) {
+    const int left = (x[i] >> kFixedShift) - radius;
+    const int top = (y[i] >> kFixedShift) - radius;
+    const int x0 = std::max(left, 0);
+    const int y0 = std::max(top, 0);
+    const int x1 = std::min(left + size, image->width);
+    const int y1 = std::min(top + size, image->height);
+    if (x0 >= x1 || y0 >= y1) continue;
+
+    const int run = (x1 - x0) * 3;
+    const uint8_t* src = sheet.stamp(hue[i]) + ((y0 - top) * size + (x0 - left)) * 3;
+    for (int row = y0; row < y1; ++row, src += size * 3) {
+      uint8_t* dst = image->row(row) + x0 * 3;
+      for (int b = 0; b < run; ++b) {
+        dst[b] = std::max(dst[b], src[b]);
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "blit.h"
+
+// Positions are fixed point with kFixedShift fractional bits.
+constexpr int kFixedShift = 8;
+constexpr int32_t kFixedOne = 1 << kFixedShift;
+
+// Sine and cosine of |angle|, a 32-bit fraction of a turn, in Q14 from a
+// 1024-entry table, so angles wrap for free and no trig runs per frame.
+int FixedSin(uint32_t angle);
+int FixedCos(uint32_t angle);
+
+// A sprite shape pre-multiplied by a wheel of fully saturated colours. Each
+// stamp is a |size| x |size| block of packed RGB, ready to be copied onto a
+// frame as is.
+class SpriteSheet {
+ public:
+  // A round dot |radius| pixels out from its centre pixel, fading linearly
+  // with the Manhattan distance (radius 1 is the classic 3x3 dot), in
+  // |hues| colours evenly around the wheel.
+  void BuildDot(int radius, int hues);
+
+  int size() const { return size_; }
+  int radius() const { return size_ / 2; }
+  int hues() const { return hues_; }
+  const uint8_t* stamp(int hue) const {
+    return stamps_.data() + static_cast<size_t>(hue) * size_ * size_ * 3;
+  }
+
+ private:
+  int size_ = 0;
+  int hues_ = 0;
+  std::vector<uint8_t> stamps_;
+};
+
+// Particle state as structure of arrays, so updates run down flat arrays
+// and hundreds of particles stay cheap.
+struct ParticleField {
+  // Centre of each particle in fixed point.
+  std::vector<int32_t> x;
+  std::vector<int32_t> y;
+  // Stamp of each particle in the sheet it is drawn with.
+  std::vector<uint16_t> hue;
+
+  void Resize(size_t count);
+  size_t size() const { return x.size(); }
+
+  // Stamps every particle onto |image|, clipped once per particle and copied
+  // a row at a time. Overlaps keep the brighter value of each channel, so
+  // the result does not depend on the order of the particles.
+  void Render(const SpriteSheet& sheet, RgbFrame* image) const;
+};
@@ -0,0 +1,179 @@
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <iostream>
+
+void SetCurrentThreadAffinity(int cpu, const char* stage) {
+  if (cpu < 0) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    std::cerr << "⚠️ Could not pin " << stage << " stage to CPU " << cpu
+              << " (error " << err << ")\n";
+  }
+}
+
+DecodeStage::DecodeStage(PayloadRing* input, DecodedRing* output,
+                         ContentCache* cache, const ColorPipeline& color,
+                         rgb_matrix::FrameCanvas* scratch,
+                         size_t prerender_budget,
+                         const std::atomic<bool>* render_waiting, int cpu)
+    : input_(input),
+      output_(output),
+      cache_(cache),
+      color_(color),
+      scratch_(scratch),
+      prerender_budget_(prerender_budget),
+      render_waiting_(render_waiting),
+      cpu_(cpu) {}
+
+DecodeStage::~DecodeStage() { Stop(); }
+
+void DecodeStage::Start() { thread_ = std::thread(&DecodeStage::Run, this); }
+
+void DecodeStage::Stop() {
+  input_->Close();
+  output_->Close();
+  if (thread_.joinable()) thread_.join();
+}
+
+void DecodeStage::Run() {
+  SetCurrentThreadAffinity(cpu_, "decode");
+  while (Payload* payload = input_->WaitRead()) {
+    DecodedApp* app = output_->WaitWrite();
+    if (app == nullptr) return;
+
+    if (payload->brightness > 0 && scratch_ != nullptr) {
+      scratch_->SetBrightness(payload->brightness);
+    }
+    app->brightness = payload->brightness;
+    app->dwell_secs = payload->dwell_secs;
+    app->preview = false;
+
+    if (payload->stream) {
+      app = AwaitStream(payload, app);
+      if (app == nullptr) return;
+      if (!payload->stream->Wait()) {
+        input_->ReleaseRead();
+        continue;
+      }
+    }
+
+    app->content = cache_->Find(payload->hash);
+    if (app->content) {
+      if (!app->content->prerendered.empty() &&
+          app->content->prerendered.brightness() != scratch_->brightness()) {
+        app->content = Rerender(*app->content);
+      }
+    } else if (payload->not_modified) {
+      std::cerr << "⚠️ 304 for content no longer cached — skipping\n";
+    } else {
+      app->content = Decode(*payload);
+    }
+    input_->ReleaseRead();
+    if (app->content) output_->CommitWrite();
+  }
+  // Nothing more is coming; the render stage finishes what it has.
+  output_->Close();
+}
+
+// Waits for a streamed body to finish. The bytes are fed to the preview
+// decoder as they land; if the render stage has nothing left to show once
+// an animation's first frame is complete, that frame is published on its
+// own so it reaches the panel without waiting for the rest. Otherwise the
+// slot is kept for the full app, which would be held up behind it. Returns
+// the slot the full app goes into, or nullptr once the ring is closed.
+DecodedApp* DecodeStage::AwaitStream(Payload* payload, DecodedApp* app) {
+  BodyStream& stream = *payload->stream;
+  preview_.Reset();
+  size_t have = 0;
+  bool done = false;
+  bool previewed = false;
+  while (!done) {
+    // Only the new bytes are copied out while the writer is held off; they
+    // are decoded once it has been let go.
+    const bool feeding = !previewed && preview_.wants_bytes();
+    stream.Read(have, [&](const uint8_t* data, size_t size, bool finished) {
+      if (feeding) fresh_.assign(data + have, data + size);
+      have = size;
+      done = finished;
+    });
+    if (done || previewed) continue;
+    if (feeding) preview_.Feed(fresh_.data(), fresh_.size());
+    if (!preview_.complete()) continue;
+    if (output_->size() > 0 && !render_waiting_->load(std::memory_order_relaxed)) {
+      continue;
+    }
+
+    previewed = true;
+    auto preview = std::make_shared<DecodedContent>();
+    preview_.Take(color_, &preview->frames);
+    preview->still = true;
+    app->content = std::move(preview);
+    app->preview = true;
+    output_->CommitWrite();
+    std::cout << "⚡ First frame out after " << have << " bytes\n";
+
+    app = output_->WaitWrite();
+    if (app == nullptr) return nullptr;
+    app->brightness = payload->brightness;
+    app->dwell_secs = payload->dwell_secs;
+    app->preview = false;
+  }
+  if (stream.Wait()) payload->hash = stream.hash();
+  return app;
+}
+
+std::shared_ptr<const DecodedContent> DecodeStage::Decode(const Payload& payload) {
+  auto content = std::make_shared<DecodedContent>();
+  content->hash = payload.hash;
+
+  WebPData webp_data;
+  webp_data.bytes = payload.data();
+  webp_data.size = payload.size();
+
+  WebPDemuxer* demux = WebPDemux(&webp_data);
+  if (!demux) {
+    std::cerr << "❌ demux creation failed — skipping decode.\n";
+    return nullptr;
+  }
+  uint32_t frame_count = WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT);
+  WebPDemuxDelete(demux);
+
+  if (frame_count == 1) {
+    content->still = true;
+    if (!DecodeStill(webp_data, payload.dwell_secs * 1000, &content->frames)) {
+      return nullptr;
+    }
+  } else {
+    // Animated WebP: decode every frame once, then replay from memory.
+    if (!DecodeAnimation(webp_data, color_, &content->frames)) {
+      std::cerr << "❌ Failed to decode animated WebP\n";
+      return nullptr;
+    }
+    // Capture the frames in the matrix's bitplane format when they fit the
+    // budget, so each loop only copies canvases instead of redrawing them.
+    if (scratch_ != nullptr) {
+      content->prerendered.Render(content->frames, scratch_, prerender_budget_);
+    }
+  }
+
+  cache_->Insert(content);
+  return content;
+}
+
+// Brightness is baked into pre-rendered frames, so a cached animation shown
+// at a new brightness gets its frames captured again.
+std::shared_ptr<const DecodedContent> DecodeStage::Rerender(const DecodedContent& cached) {
+  auto content = std::make_shared<DecodedContent>();
+  content->hash = cached.hash;
+  content->still = cached.still;
+  content->frames = cached.frames;
+  content->prerendered.Render(content->frames, scratch_, prerender_budget_);
+  cache_->Insert(content);
+  return content;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "color.h"
+#include "content_cache.h"
+#include "fetcher.h"
+#include "frame_cache.h"
+#include "led-matrix.h"
+#include "prerender.h"
+#include "spsc_ring.h"
+
+// An app ready for the render stage: its decoded frames plus the settings
+// that came with this particular response.
+struct DecodedApp {
+  std::shared_ptr<const DecodedContent> content;
+  int brightness = 0;
+  int dwell_secs = 10;
+  // Only the first frame of the app in the next slot, published while the
+  // rest of it is still downloading. Shown until that slot is ready.
+  bool preview = false;
+};
+
+// Two slots: one on the panel, one being prepared behind it.
+using DecodedRing = SpscRing<DecodedApp, 2>;
+
+// Pins the calling thread to |cpu|. Negative values leave it unpinned.
+void SetCurrentThreadAffinity(int cpu, const char* stage);
+
+// Middle stage of the display pipeline: takes fetched payloads, demuxes and
+// decodes them, converts the frames for the panel and pre-renders them into
+// |scratch|, a FrameCanvas that is never put on screen (null skips that). Payloads already in
+// |cache| skip all of that. Streamed payloads are watched while they arrive
+// so an animation's first frame can go out ahead of the rest when the
+// render stage is idle or only looping an app past its dwell
+// (|render_waiting|). Once |input| is closed and drained, |output| is closed
+// behind the last app.
+class DecodeStage {
+ public:
+  DecodeStage(PayloadRing* input, DecodedRing* output, ContentCache* cache,
+              const ColorPipeline& color, rgb_matrix::FrameCanvas* scratch,
+              size_t prerender_budget,
+              const std::atomic<bool>* render_waiting, int cpu = -1);
+  ~DecodeStage();
+
+  void Start();
+  void Stop();
+
+ private:
+  void Run();
+  DecodedApp* AwaitStream(Payload* payload, DecodedApp* app);
+  std::shared_ptr<const DecodedContent> Decode(const Payload& payload);
+  std::shared_ptr<const DecodedContent> Rerender(const DecodedContent& cached);
+
+  PayloadRing* const input_;
+  DecodedRing* const output_;
+  ContentCache* const cache_;
+  const ColorPipeline& color_;
+  rgb_matrix::FrameCanvas* const scratch_;
+  const size_t prerender_budget_;
+  const std::atomic<bool>* const render_waiting_;
+  const int cpu_;
+  std::thread thread_;
+  FirstFrameDecoder preview_;
+  std::vector<uint8_t> fresh_;  // stream bytes new since the last look
+};
@@ -0,0 +1,50 @@
+#include "polar_map.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+void HueToRGB(int hue, uint8_t rgb[3]) {
+  hue %= kHueSteps;
+  if (hue < 0) hue += kHueSteps;
+  const uint8_t rise = hue & 255;
+  const uint8_t fall = 255 - rise;
+  switch (hue >> 8) {
+    case 0: rgb[0] = 255;  rgb[1] = rise; rgb[2] = 0;    break;
+    case 1: rgb[0] = fall; rgb[1] = 255;  rgb[2] = 0;    break;
+    case 2: rgb[0] = 0;    rgb[1] = 255;  rgb[2] = rise; break;
+    case 3: rgb[0] = 0;    rgb[1] = fall; rgb[2] = 255;  break;
+    case 4: rgb[0] = rise; rgb[1] = 0;    rgb[2] = 255;  break;
+    default: rgb[0] = 255; rgb[1] = 0;    rgb[2] = fall; break;
+  }
+}
+
+void PolarMap::Resize(int width, int height) {
+  if (width == width_ && height == height_) return;
+  width_ = width;
+  height_ = height;
+  distance_.resize(static_cast<size_t>(width) * height);
+  angle_.resize(distance_.size());
+  max_distance_ = 0;
+
+  const int cx = width / 2;
+  const int cy = height / 2;
+  size_t i = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x, ++i) {
+      const int dx = x - cx;
+      const int dy = y - cy;
+      const int dist = static_cast<int>(sqrt(static_cast<double>(dx * dx + dy * dy)));
+      distance_[i] = dist;
+      max_distance_ = std::max(max_distance_, dist);
+      const double turn = (atan2(dy, dx) + M_PI) / (2 * M_PI);
+      angle_[i] = std::min(static_cast<int>(turn * 256), 255);
+    }
+  }
+}
+
+void BuildHueRamp(int base, int span, HueRamp* ramp) {
+  for (int i = 0; i < 256; ++i) {
+    HueToRGB(base + i * span / 256, (*ramp)[i].data());
+  }
+}
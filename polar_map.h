@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <vector>
+
+// Hue in 1/256ths of a 60° sector: 0..kHueSteps-1 covers the whole wheel.
+constexpr int kHueSteps = 6 * 256;
+
+// Fully saturated RGB for |hue|, at full value. Integer counterpart of
+// HSVtoRGB(h, 1, 1) with h = hue * 360 / kHueSteps.
+void HueToRGB(int hue, uint8_t rgb[3]);
+
+// Distance and direction of every pixel from the centre of a canvas, so
+// radial effects cost table lookups per frame instead of sqrt and atan2.
+// Rebuilt only when the canvas size changes.
+class PolarMap {
+ public:
+  void Resize(int width, int height);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int max_distance() const { return max_distance_; }
+
+  // Both indexed by y * width + x.
+  // floor(sqrt(dx * dx + dy * dy)).
+  const uint16_t* distance() const { return distance_.data(); }
+  // atan2(dy, dx) mapped from [-pi, pi) onto 0..255.
+  const uint8_t* angle() const { return angle_.data(); }
+
+ private:
+  int width_ = 0;
+  int height_ = 0;
+  int max_distance_ = 0;
+  std::vector<uint16_t> distance_;
+  std::vector<uint8_t> angle_;
+};
+
+// 256 fully saturated colours starting at |base| and spanning |span| hue
+// steps, so an angle byte from PolarMap picks its colour directly.
+using HueRamp = std::array<std::array<uint8_t, 3>, 256>;
+void BuildHueRamp(int base, int span, HueRamp* ramp);
@@ -0,0 +1,49 @@
+#include "prerender.h"
+
+#include <string.h>
+
+#include <iostream>
+
+#include "blit.h"
+
+bool PrerenderedAnimation::Render(const FrameCache& frames,
+                                  rgb_matrix::FrameCanvas* scratch,
+                                  size_t byte_budget) {
+  Clear();
+  if (frames.frame_count() == 0) return false;
+  brightness_ = scratch->brightness();
+
+  for (size_t i = 0; i < frames.frame_count(); ++i) {
+    scratch->Clear();
+    BlitRGB(scratch, 0, 0, frames.width, frames.height, frames.frame(i),
+            frames.width * 3);
+
+    const char* serialized = nullptr;
+    size_t len = 0;
+    scratch->Serialize(&serialized, &len);
+    if (i == 0) {
+      if (len * frames.frame_count() > byte_budget) {
+        std::cout << "Pre-render skipped: " << frames.frame_count() << " frames x "
+                  << len << " bytes exceeds budget\n";
+        return false;
+      }
+      frame_bytes_ = len;
+      data_.resize(len * frames.frame_count());
+    }
+    memcpy(data_.data() + i * frame_bytes_, serialized, frame_bytes_);
+    durations_ms_.push_back(frames.durations_ms[i]);
+  }
+  return true;
+}
+
+void PrerenderedAnimation::Clear() {
+  data_.clear();
+  frame_bytes_ = 0;
+  brightness_ = 0;
+  durations_ms_.clear();
+}
+
+bool PrerenderedAnimation::Load(size_t index,
+                                rgb_matrix::FrameCanvas* canvas) const {
+  return canvas->Deserialize(data_.data() + index * frame_bytes_, frame_bytes_);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "frame_cache.h"
+#include "led-matrix.h"
+
+// Animation frames kept in the matrix's own bitplane format. Each frame is
+// drawn once per payload and captured with FrameCanvas::Serialize, the same
+// representation the library's content-streamer uses, so playback is a
+// Deserialize (a memcpy) and a SwapOnVSync with no pixel work at all.
+class PrerenderedAnimation {
+ public:
+  // Draws every frame of |frames| through |scratch| and captures it. Gives up
+  // and stays empty if the frames would need more than |byte_budget| bytes.
+  // |scratch| must not be on screen; its contents are left undefined.
+  bool Render(const FrameCache& frames, rgb_matrix::FrameCanvas* scratch,
+              size_t byte_budget);
+
+  // Drops the frames but keeps the allocation for the next payload.
+  void Clear();
+
+  bool empty() const { return durations_ms_.empty(); }
+  size_t bytes() const { return data_.size(); }
+  // Brightness of the canvas the frames were captured from; the matrix
+  // applies brightness when pixels are set, so it is baked into the frames.
+  int brightness() const { return brightness_; }
+  size_t frame_count() const { return durations_ms_.size(); }
+  int duration_ms(size_t index) const { return durations_ms_[index]; }
+
+  // Copies frame |index| into |canvas|, which must share the geometry of the
+  // canvas the frames were rendered with.
+  bool Load(size_t index, rgb_matrix::FrameCanvas* canvas) const;
+
+ private:
+  std::vector<char> data_;
+  size_t frame_bytes_ = 0;
+  int brightness_ = 0;
+  std::vector<int> durations_ms_;
+};
@@ -0,0 +1,134 @@
+#include "push_transport.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "json.hpp"
+
+namespace {
+
+constexpr uint32_t kMinReconnectMs = 1000;
+constexpr uint32_t kMaxReconnectMs = 60000;
+constexpr int kPingIntervalSecs = 30;
+
+}  // namespace
+
+std::string DerivePushUrl(const std::string& url) {
+  std::string push_url;
+  if (url.starts_with("https://")) {
+    push_url = "wss://" + url.substr(8);
+  } else if (url.starts_with("http://")) {
+    push_url = "ws://" + url.substr(7);
+  } else {
+    return "";
+  }
+  if (push_url.ends_with("/next")) {
+    push_url.replace(push_url.size() - 4, 4, "ws");
+  }
+  return push_url;
+}
+
+PushTransport::PushTransport(const std::string& url) : url_(url) {
+  socket_.setUrl(url_);
+  socket_.setPingInterval(kPingIntervalSecs);
+  socket_.enableAutomaticReconnection();
+  socket_.setMinWaitBetweenReconnectionRetries(kMinReconnectMs);
+  socket_.setMaxWaitBetweenReconnectionRetries(kMaxReconnectMs);
+  socket_.setOnMessageCallback(
+      [this](const ix::WebSocketMessagePtr& msg) { OnMessage(msg); });
+}
+
+PushTransport::~PushTransport() { Stop(); }
+
+void PushTransport::Start() { socket_.start(); }
+
+void PushTransport::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopped_ = true;
+    ready_.notify_all();
+  }
+  socket_.stop();
+  std::lock_guard<std::mutex> lock(mutex_);
+  connected_.store(false, std::memory_order_release);
+}
+
+bool PushTransport::Wait(Payload* payload, std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ready_.wait_for(lock, timeout, [this] {
+    return has_pending_ || stopped_ || !connected();
+  });
+  if (!has_pending_) return false;
+  has_pending_ = false;
+  // Swapping keeps both buffers' capacity for the next push.
+  payload->body.swap(pending_);
+  payload->mapped.reset();
+  payload->not_modified = false;
+  payload->brightness = brightness_;
+  payload->dwell_secs = dwell_secs_;
+  return true;
+}
+
+void PushTransport::OnMessage(const ix::WebSocketMessagePtr& msg) {
+  switch (msg->type) {
+    case ix::WebSocketMessageType::Open:
+      std::cout << "🔌 Push connected: " << url_ << std::endl;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.store(true, std::memory_order_release);
+      }
+      break;
+    case ix::WebSocketMessageType::Close:
+    case ix::WebSocketMessageType::Error: {
+      bool was_connected;
+      {
+        // Changed under the lock that Wait's predicate reads it under, so
+        // the wakeup that sends the fetch stage back to polling is not lost.
+        std::lock_guard<std::mutex> lock(mutex_);
+        was_connected = connected_.exchange(false, std::memory_order_acq_rel);
+        ready_.notify_all();
+      }
+      if (was_connected) {
+        std::cout << "🔌 Push disconnected, polling until it is back\n";
+      }
+      if (msg->type == ix::WebSocketMessageType::Error) {
+        std::cerr << "Push connection failed: " << msg->errorInfo.reason
+                  << " (retry in " << msg->errorInfo.wait_time << " ms)" << std::endl;
+      }
+      break;
+    }
+    case ix::WebSocketMessageType::Message:
+      if (!msg->binary) {
+        OnControl(msg->str);
+        break;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.assign(msg->str);
+        has_pending_ = true;
+        ready_.notify_one();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void PushTransport::OnControl(const std::string& text) {
+  nlohmann::json msg = nlohmann::json::parse(text, nullptr, false);
+  if (msg.is_discarded() || !msg.is_object()) {
+    std::cerr << "Invalid push message: " << text << std::endl;
+    return;
+  }
+  // Applies from the next app on, the same as the response headers.
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto brightness = msg.find("brightness");
+  if (brightness != msg.end() && brightness->is_number()) {
+    brightness_ = std::clamp(brightness->get<int>(), 1, 50);
+  }
+  auto dwell = msg.find("dwell_secs");
+  if (dwell != msg.end() && dwell->is_number()) {
+    dwell_secs_ = std::max(dwell->get<int>(), 1);
+  }
+}
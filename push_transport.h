@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "fetcher.h"
+#include "ixwebsocket/IXWebSocket.h"
+
+// Turns the poll URL (http://host/<device>/next) into the server's push
+// endpoint (ws://host/<device>/ws).
+std::string DerivePushUrl(const std::string& url);
+
+// Persistent WebSocket to the Tronbyt server. The server pushes each app as
+// a binary WebP message the moment it is rendered, and brightness/dwell
+// changes as small JSON text messages ({"brightness": 20, "dwell_secs": 15}).
+//
+// The socket reconnects on its own with exponential backoff. While it is
+// down the fetch stage falls back to polling, so push is purely a latency
+// win and never a new way to go dark.
+class PushTransport {
+ public:
+  explicit PushTransport(const std::string& url);
+  ~PushTransport();
+
+  void Start();
+  void Stop();
+
+  bool connected() const { return connected_.load(std::memory_order_acquire); }
+
+  // Waits up to |timeout| for the next pushed app and moves it into
+  // |payload| with the latest brightness and dwell. Returns false on
+  // timeout, or as soon as the socket drops or the transport stops.
+  // Only the newest app is kept if several arrive between calls.
+  bool Wait(Payload* payload, std::chrono::milliseconds timeout);
+
+ private:
+  void OnMessage(const ix::WebSocketMessagePtr& msg);
+  void OnControl(const std::string& text);
+
+  const std::string url_;
+  ix::WebSocket socket_;
+  std::atomic<bool> connected_{false};
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::string pending_;
+  bool has_pending_ = false;
+  bool stopped_ = false;
+  int brightness_ = 0;  // 0 until the server sends one
+  int dwell_secs_ = 10;
+};
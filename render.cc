@@ -0,0 +1,105 @@
+#include "render.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+void ShowFrame(DisplaySink* display, const DecodedContent& content, size_t index) {
+  if (content.prerendered.empty() || !display->Load(content.prerendered, index)) {
+    const FrameCache& frames = content.frames;
+    display->Blit(0, 0, frames.width, frames.height, frames.frame(index), frames.width * 3);
+  }
+}
+
+// Plays |app| for its dwell time, then until the next app is ready.
+PacingStats PlayApp(DisplaySink* display, const DecodedApp& app, const DecodedRing& decoded,
+                    const PayloadRing& payloads, std::atomic<bool>* waiting,
+                    TimeSource* time) {
+  auto start_time = time->Now();
+  auto next_ready = [&decoded, &payloads] {
+    return decoded.size() > 1 || payloads.size() > 0 || decoded.closed();
+  };
+  FramePacer pacer(LatePolicy::kDropFrames, time);
+  const DecodedContent& content = *app.content;
+
+  if (content.still) {
+    ShowFrame(display, content, 0);
+    display->Swap();
+    if (!app.preview) pacer.Wait(std::chrono::seconds(app.dwell_secs));
+    waiting->store(true, std::memory_order_relaxed);
+    while (!next_ready()) {
+      time->SleepFor(50ms);
+    }
+    return pacer.stats();
+  }
+
+  const FrameCache& frames = content.frames;
+  while (true) {
+    for (size_t i = 0; i < frames.frame_count(); ++i) {
+      auto duration = std::chrono::milliseconds(frames.durations_ms[i]);
+      if (pacer.ShouldDrop(duration)) continue;
+      ShowFrame(display, content, i);
+      display->Swap();
+      pacer.Wait(duration);
+    }
+
+    auto now = time->Now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
+    if (elapsed >= app.dwell_secs) {
+      if (next_ready()) {
+        pacer.Report("App");
+        return pacer.stats();
+      }
+      waiting->store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace
+
+RenderStats RunRenderStage(DisplaySink* display, DecodedRing* decoded,
+                           const PayloadRing& payloads, TransitionEngine* transitions,
+                           std::atomic<bool>* render_waiting, TimeSource* time) {
+  RenderStats stats;
+  auto always = [] { return true; };
+  auto next_decoded = [decoded] { return decoded->size() > 1 || decoded->closed(); };
+  uint64_t last_hash = 0;
+  bool last_was_preview = false;
+  bool led_in = false;
+  while (const DecodedApp* app = decoded->WaitRead()) {
+    render_waiting->store(false, std::memory_order_relaxed);
+    if (app->brightness > 0) display->SetBrightness(app->brightness);
+
+    // The same content again (a single-app rotation) just keeps playing, and
+    // an app whose first frame was previewed picks up without a transition.
+    if (app->content->hash != last_hash && !last_was_preview && !led_in) {
+      stats.pacing.Add(transitions->Play(display, always));
+      stats.transitions++;
+    }
+    last_hash = app->content->hash;
+    last_was_preview = app->preview;
+
+    stats.pacing.Add(PlayApp(display, *app, *decoded, payloads, render_waiting, time));
+    stats.apps++;
+
+    // Lead into the next app while it is still decoding, so switching costs
+    // the transition rather than the transition plus the decode. If it is
+    // already decoded, blend straight from this app's last frame into it.
+    // Nothing is led into once the ring is closed behind this app.
+    const bool closed = decoded->closed();
+    const DecodedApp* next = decoded->Peek(1);
+    led_in = !app->preview && !(next && next->content->hash == app->content->hash) &&
+             !(next == nullptr && closed);
+    if (led_in) {
+      render_waiting->store(true, std::memory_order_relaxed);
+      if (next != nullptr) {
+        const FrameCache& frames = app->content->frames;
+        transitions->SetEnds(frames, frames.frame_count() - 1, next->content->frames);
+      }
+      stats.pacing.Add(transitions->Play(display, next_decoded));
+      stats.transitions++;
+    }
+    decoded->ReleaseRead();
+  }
+  return stats;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "display.h"
+#include "fetcher.h"
+#include "frame_pacer.h"
+#include "pipeline.h"
+#include "time_source.h"
+#include "transitions.h"
+
+// What the render stage did, over the whole run.
+struct RenderStats {
+  uint64_t apps = 0;
+  uint64_t transitions = 0;
+  PacingStats pacing;  // apps and transitions together
+};
+
+// Last stage of the display pipeline, on the calling thread. Plays every app
+// from |decoded| on |display| for its dwell time, then keeps it going until
+// the next app is decoded or at least being fetched (|payloads|), so the
+// panel never waits on the network. |render_waiting| tells the decode stage
+// when the dwell is over. Switches between apps go through |transitions|.
+// Everything is paced on |time|. Returns once |decoded| is closed and
+// played out.
+RenderStats RunRenderStage(DisplaySink* display, DecodedRing* decoded,
+                           const PayloadRing& payloads, TransitionEngine* transitions,
+                           std::atomic<bool>* render_waiting,
+                           TimeSource* time = SystemTime());
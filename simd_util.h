@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+// Picks the instruction set the kernel files build vector versions for.
+// x86 kernels are compiled per function with target attributes and chosen
+// at runtime; NEON ones only when the compiler targets it.
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRONBERRY_X86_KERNELS 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#define TRONBERRY_NEON_KERNELS 1
+#endif
+
+#if defined(TRONBERRY_NEON_KERNELS)
+
+// Div255 on eight 16-bit lanes, narrowed to bytes.
+inline uint8x8_t Div255NEON(uint16x8_t x) {
+  return vshrn_n_u16(vsraq_n_u16(vaddq_u16(x, vdupq_n_u16(1)), x, 8), 8);
+}
+
+// 32-bit ARM builds may still run on cores without NEON.
+inline bool HasNEON() {
+#if defined(__aarch64__)
+  return true;
+#else
+  return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+}
+
+#endif  // TRONBERRY_NEON_KERNELS
+
+// The kernels compiled in and supported by this CPU, added scalar first and
+// fastest last. Build one in a function-local static so detection runs once.
+template <typename Kernel, int kMax>
+class KernelTable {
+ public:
+  KernelTable() {
+#if defined(TRONBERRY_X86_KERNELS)
+    __builtin_cpu_init();
+#endif
+  }
+
+  void Add(const Kernel& kernel) {
+    if (count_ < kMax) kernels_[count_++] = kernel;
+  }
+
+  const Kernel& best() const { return kernels_[count_ - 1]; }
+
+  // Points |kernels| at every entry and returns the count.
+  int List(const Kernel** kernels) const {
+    *kernels = kernels_;
+    return count_;
+  }
+
+ private:
+  Kernel kernels_[kMax];
+  int count_ = 0;
+};
@@ -0,0 +1,147 @@
+#include "splash.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+// Packed layout: "TBSP", then width, height and frame count as varints
+// (LEB128). Each frame is its duration in milliseconds followed by runs that
+// cover its pixels in order, each a varint of count << 2 | op:
+//
+//   kSkip  count pixels unchanged from the previous frame
+//   kCopy  count RGBA pixels follow
+//   kFill  one RGBA pixel follows, repeated count times
+
+namespace {
+
+constexpr uint8_t kMagic[4] = {'T', 'B', 'S', 'P'};
+
+enum Op : uint32_t { kSkip = 0, kCopy = 1, kFill = 2 };
+
+// A run of identical pixels shorter than this is cheaper copied.
+constexpr int kMinFill = 3;
+
+void PutVarint(uint32_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+bool SamePixel(const uint8_t* a, const uint8_t* b, int i, int j) {
+  return memcmp(a + i * 4, b + j * 4, 4) == 0;
+}
+
+// Length of the run of pixels equal to pixel |i| of |frame|.
+int FillLength(const uint8_t* frame, int i, int pixels) {
+  int n = 1;
+  while (i + n < pixels && SamePixel(frame, frame, i, i + n)) ++n;
+  return n;
+}
+
+}  // namespace
+
+void EncodeSplashHeader(int width, int height, int frame_count,
+                        std::vector<uint8_t>* out) {
+  out->insert(out->end(), kMagic, kMagic + 4);
+  PutVarint(width, out);
+  PutVarint(height, out);
+  PutVarint(frame_count, out);
+}
+
+void EncodeSplashFrame(const uint8_t* previous, const uint8_t* frame,
+                       int pixels, int duration_ms, std::vector<uint8_t>* out) {
+  PutVarint(duration_ms, out);
+  int i = 0;
+  while (i < pixels) {
+    int n = 0;
+    while (i + n < pixels && SamePixel(previous, frame, i + n, i + n)) ++n;
+    if (n > 0) {
+      PutVarint(n << 2 | kSkip, out);
+      i += n;
+      continue;
+    }
+    n = FillLength(frame, i, pixels);
+    if (n >= kMinFill) {
+      PutVarint(n << 2 | kFill, out);
+      out->insert(out->end(), frame + i * 4, frame + i * 4 + 4);
+      i += n;
+      continue;
+    }
+    // Copy up to the next pixel that can be skipped or starts a fill.
+    n = 1;
+    while (i + n < pixels && !SamePixel(previous, frame, i + n, i + n) &&
+           FillLength(frame, i + n, std::min(pixels, i + n + kMinFill)) < kMinFill) {
+      ++n;
+    }
+    PutVarint(n << 2 | kCopy, out);
+    out->insert(out->end(), frame + i * 4, frame + (i + n) * 4);
+    i += n;
+  }
+}
+
+bool SplashDecoder::Open(const uint8_t* data, size_t size) {
+  data_ = data;
+  end_ = data + size;
+  next_frame_ = 0;
+  if (size < 4 || memcmp(data, kMagic, 4) != 0) return false;
+  data_ += 4;
+  uint32_t width, height, frames;
+  if (!ReadVarint(&width) || !ReadVarint(&height) || !ReadVarint(&frames)) {
+    return false;
+  }
+  if (width == 0 || height == 0 || width > 1024 || height > 1024) return false;
+  width_ = width;
+  height_ = height;
+  frame_count_ = frames;
+  rgba_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+  return true;
+}
+
+bool SplashDecoder::Next(int* duration_ms) {
+  if (next_frame_ >= frame_count_) return false;
+  uint32_t duration;
+  if (!ReadVarint(&duration)) return false;
+
+  const uint32_t pixels = width_ * height_;
+  uint32_t i = 0;
+  while (i < pixels) {
+    uint32_t run;
+    if (!ReadVarint(&run)) return false;
+    const uint32_t n = run >> 2;
+    if (n == 0 || n > pixels - i) return false;
+    uint8_t* out = rgba_.data() + i * 4;
+    switch (run & 3) {
+      case kSkip:
+        break;
+      case kCopy:
+        if (static_cast<size_t>(end_ - data_) < n * 4) return false;
+        memcpy(out, data_, n * 4);
+        data_ += n * 4;
+        break;
+      case kFill:
+        if (end_ - data_ < 4) return false;
+        for (uint32_t k = 0; k < n; ++k) memcpy(out + k * 4, data_, 4);
+        data_ += 4;
+        break;
+      default:
+        return false;
+    }
+    i += n;
+  }
+  *duration_ms = duration;
+  ++next_frame_;
+  return true;
+}
+
+bool SplashDecoder::ReadVarint(uint32_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 32; shift += 7) {
+    if (data_ >= end_) return false;
+    const uint8_t byte = *data_++;
+    *value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
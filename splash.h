@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// The boot splash, converted from STARTUP_WEBP at build time by splash_pack
+// into splash_frames.cc, so showing it takes no libwebp work at all.
+extern const uint8_t SPLASH_FRAMES[];
+extern const size_t SPLASH_FRAMES_LEN;
+
+// Writes the header of a packed animation of |frame_count| frames to |out|.
+void EncodeSplashHeader(int width, int height, int frame_count,
+                        std::vector<uint8_t>* out);
+
+// Appends |frame|, |pixels| RGBA pixels shown for |duration_ms|, to |out| as
+// runs against |previous|, the frame before it (all zero for the first).
+void EncodeSplashFrame(const uint8_t* previous, const uint8_t* frame,
+                       int pixels, int duration_ms, std::vector<uint8_t>* out);
+
+// Plays back a packed animation by applying each frame's runs to one RGBA
+// canvas. Frames are kept as RGBA rather than panel RGB so GAMMA and the
+// other colour settings still apply to the splash.
+class SplashDecoder {
+ public:
+  // Reads the header of |data|, which must outlive the decoder.
+  bool Open(const uint8_t* data, size_t size);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int frame_count() const { return frame_count_; }
+
+  // Applies the next frame to rgba(). Returns false after the last frame or
+  // if the data is damaged.
+  bool Next(int* duration_ms);
+  const uint8_t* rgba() const { return rgba_.data(); }
+
+ private:
+  bool ReadVarint(uint32_t* value);
+
+  const uint8_t* data_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int frame_count_ = 0;
+  int next_frame_ = 0;
+  std::vector<uint8_t> rgba_;
+};
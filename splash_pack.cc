@@ -0,0 +1,74 @@
+// Build step: decodes the embedded startup WebP once on the build machine
+// and writes it out as splash_frames.cc, a packed frame sequence the
+// daemon plays without libwebp (see splash.h).
+//
+//   ./splash_pack splash_frames.cc
+#include <stdio.h>
+
+#include <vector>
+
+#include <webp/demux.h>
+
+#include "splash.h"
+#include "startup.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: splash_pack <output.cc>\n");
+    return 1;
+  }
+
+  WebPData webp_data;
+  webp_data.bytes = STARTUP_WEBP;
+  webp_data.size = STARTUP_WEBP_LEN;
+  WebPAnimDecoderOptions options;
+  WebPAnimDecoderOptionsInit(&options);
+  options.color_mode = MODE_RGBA;
+  WebPAnimDecoder* decoder = WebPAnimDecoderNew(&webp_data, &options);
+  WebPAnimInfo info;
+  if (decoder == nullptr || !WebPAnimDecoderGetInfo(decoder, &info)) {
+    fprintf(stderr, "Failed to decode the startup WebP\n");
+    WebPAnimDecoderDelete(decoder);
+    return 1;
+  }
+
+  const int pixels = info.canvas_width * info.canvas_height;
+  std::vector<uint8_t> packed;
+  EncodeSplashHeader(info.canvas_width, info.canvas_height, info.frame_count, &packed);
+  std::vector<uint8_t> previous(static_cast<size_t>(pixels) * 4, 0);
+  uint8_t* frame;
+  int timestamp, last_timestamp = 0, frames = 0;
+  while (WebPAnimDecoderHasMoreFrames(decoder)) {
+    if (!WebPAnimDecoderGetNext(decoder, &frame, &timestamp)) break;
+    EncodeSplashFrame(previous.data(), frame, pixels, timestamp - last_timestamp, &packed);
+    previous.assign(frame, frame + previous.size());
+    last_timestamp = timestamp;
+    ++frames;
+  }
+  WebPAnimDecoderDelete(decoder);
+  if (frames != static_cast<int>(info.frame_count)) {
+    fprintf(stderr, "Startup WebP ended after %d of %u frames\n", frames, info.frame_count);
+    return 1;
+  }
+
+  FILE* out = fopen(argv[1], "w");
+  if (out == nullptr) {
+    perror(argv[1]);
+    return 1;
+  }
+  fprintf(out, "// Generated by splash_pack from startup.cc; do not edit.\n");
+  fprintf(out, "#include \"splash.h\"\n\n");
+  fprintf(out, "const size_t SPLASH_FRAMES_LEN = %zu;\n", packed.size());
+  fprintf(out, "const uint8_t SPLASH_FRAMES[] = {");
+  for (size_t i = 0; i < packed.size(); ++i) {
+    fprintf(out, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", packed[i]);
+  }
+  fprintf(out, "\n};\n");
+  if (fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  fprintf(stderr, "Packed %d splash frames (%dx%d) from %zu into %zu bytes\n", frames,
+          info.canvas_width, info.canvas_height, STARTUP_WEBP_LEN, packed.size());
+  return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring of preallocated slots.
+// Slots are reused in place, so anything they own (strings, vectors) keeps
+// its capacity from one pass to the next. The producer fills the slot from
+// AcquireWrite() and publishes it with CommitWrite(); the consumer reads
+// AcquireRead() and hands it back with ReleaseRead(). The Wait* variants
+// park on a futex-backed atomic instead of spinning.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N > 0, "ring needs at least one slot");
+
+ public:
+  // Producer side.
+  T* AcquireWrite() { return CanWrite() ? WriteSlot() : nullptr; }
+  void CommitWrite() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+    Signal();
+  }
+  // Blocks until a slot is free. Returns nullptr once the ring is closed.
+  T* WaitWrite() { return Wait([this] { return CanWrite(); }) ? WriteSlot() : nullptr; }
+
+  // Consumer side.
+  T* AcquireRead() { return CanRead() ? ReadSlot() : nullptr; }
+  void ReleaseRead() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+    Signal();
+  }
+  // Blocks until a slot is readable. Returns nullptr once the ring is closed
+  // and every slot committed before that has been read.
+  T* WaitRead() { return Wait([this] { return CanRead(); }, true) ? ReadSlot() : nullptr; }
+  // The committed slot |index| places past the one AcquireRead() returns,
+  // or nullptr if the producer has not got that far.
+  const T* Peek(size_t index) const {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (tail_.load(std::memory_order_acquire) - head <= index) return nullptr;
+    return &slots_[(head + index) % N];
+  }
+
+  // Number of committed slots not yet released, as seen by the consumer.
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_relaxed);
+  }
+
+  // Wakes both sides and makes every later WaitWrite return nullptr, and
+  // WaitRead once the consumer has caught up.
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    Signal();
+  }
+  bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+ private:
+  void Signal() {
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+  }
+
+  bool CanWrite() const {
+    return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) != N;
+  }
+  bool CanRead() const {
+    return tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_relaxed);
+  }
+  T* WriteSlot() { return &slots_[tail_.load(std::memory_order_relaxed) % N]; }
+  T* ReadSlot() { return &slots_[head_.load(std::memory_order_relaxed) % N]; }
+
+  // Waits on the slot indices rather than on slot pointers, so the closed
+  // check never sits behind a null test on a slot address.
+  template <typename Fn>
+  bool Wait(Fn ready, bool drain = false) {
+    while (true) {
+      uint32_t seen = signal_.load(std::memory_order_acquire);
+      if (drain && ready()) return true;
+      if (closed()) return false;
+      if (ready()) return true;
+      signal_.wait(seen, std::memory_order_acquire);
+    }
+  }
+
+  std::array<T, N> slots_;
+  alignas(64) std::atomic<uint32_t> head_{0};
+  alignas(64) std::atomic<uint32_t> tail_{0};
+  alignas(64) std::atomic<uint32_t> signal_{0};
+  std::atomic<bool> closed_{false};
+};
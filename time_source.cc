@@ -0,0 +1,59 @@
+#include "time_source.h"
+
+#include <time.h>
+
+#include <cerrno>
+
+namespace {
+
+class SystemTimeSource : public TimeSource {
+ public:
+  Clock::time_point Now() override { return Clock::now(); }
+
+  void SleepUntil(Clock::time_point deadline) override {
+    auto since_epoch = deadline.time_since_epoch();
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    timespec ts;
+    ts.tv_sec = secs.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - secs).count();
+    // steady_clock is CLOCK_MONOTONIC on Linux.
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+  }
+};
+
+}  // namespace
+
+TimeSource* SystemTime() {
+  static SystemTimeSource system;
+  return &system;
+}
+
+TimeSource::Clock::time_point SimulatedTime::Now() {
+  return Clock::time_point(std::chrono::nanoseconds(now_ns_.load(std::memory_order_acquire)));
+}
+
+void SimulatedTime::SleepUntil(Clock::time_point deadline) {
+  if (on_sleep_) on_sleep_();
+  const int64_t to = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         deadline.time_since_epoch()).count();
+  int64_t now = now_ns_.load(std::memory_order_relaxed);
+  while (now < to && !now_ns_.compare_exchange_weak(now, to, std::memory_order_acq_rel)) {
+  }
+}
+
+void SimulatedTime::Advance(Clock::duration duration) {
+  now_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+                    std::memory_order_acq_rel);
+}
+
+ScaledTime::ScaledTime(double speed) : speed_(speed), start_(Clock::now()) {}
+
+TimeSource::Clock::time_point ScaledTime::Now() {
+  return start_ + std::chrono::duration_cast<Clock::duration>((Clock::now() - start_) * speed_);
+}
+
+void ScaledTime::SleepUntil(Clock::time_point deadline) {
+  SystemTime()->SleepUntil(
+      start_ + std::chrono::duration_cast<Clock::duration>((deadline - start_) / speed_));
+}
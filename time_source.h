@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Where the render path reads the time and sleeps. Pacing goes through one
+// of these rather than the steady clock, so a run can be put on simulated
+// time and hours of rotation play out in seconds.
+class TimeSource {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  virtual ~TimeSource() = default;
+
+  virtual Clock::time_point Now() = 0;
+  // Returns once Now() has reached |deadline|.
+  virtual void SleepUntil(Clock::time_point deadline) = 0;
+
+  void SleepFor(Clock::duration duration) { SleepUntil(Now() + duration); }
+};
+
+// The monotonic clock, used by everything that is not given another.
+TimeSource* SystemTime();
+
+// Time that stands still until someone sleeps, then jumps straight to the
+// deadline. Drawing takes no time on it, so every pacing decision and frame
+// count comes out the same on every run and every machine.
+class SimulatedTime : public TimeSource {
+ public:
+  Clock::time_point Now() override;
+  void SleepUntil(Clock::time_point deadline) override;
+
+  // Moves the clock on by |duration| without a sleep, as slow work would.
+  void Advance(Clock::duration duration);
+
+  // Called on the sleeping thread before every jump, e.g. to let other
+  // threads settle first so they always see the same moment.
+  void OnSleep(std::function<void()> callback) { on_sleep_ = std::move(callback); }
+
+ private:
+  std::atomic<int64_t> now_ns_{0};
+  std::function<void()> on_sleep_;
+};
+
+// The monotonic clock run |speed| times as fast from the moment this is
+// made, e.g. to replay an hour of capture in six minutes at speed 10.
+class ScaledTime : public TimeSource {
+ public:
+  explicit ScaledTime(double speed);
+
+  Clock::time_point Now() override;
+  void SleepUntil(Clock::time_point deadline) override;
+
+ private:
+  const double speed_;
+  const Clock::time_point start_;
+};
@@ -0,0 +1,503 @@
+#include "transitions.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "blend_kernels.h"
+#include "color.h"
+#include "frame_pacer.h"
+#include "particles.h"
+#include "polar_map.h"
+
+namespace {
+
+// The two transitions tronberry has always had, as definitions, to cover
+// decodes, and a short crossfade for apps that are ready in time.
+constexpr const char* kBuiltinTransitions = R"([
+  {"name": "OrbitDots", "type": "orbit", "frame_ms": 22, "frames": 72,
+   "dots": 4},
+  {"name": "Pulse", "type": "pulse", "frame_ms": 16, "frames": 24,
+   "min_cycles": 2, "fade": 6, "hue_span": 60},
+  {"name": "Crossfade", "type": "crossfade", "frame_ms": 16,
+   "duration_ms": 480}
+])";
+
+// Limits on the timing fields, so a typo cannot hold the panel for hours.
+constexpr int kMaxFrameMs = 1000;
+constexpr int kMaxFrames = 1000;
+constexpr int kMaxDurationMs = 10000;
+constexpr int kMaxMinCycles = 10;
+
+std::map<std::string, TransitionCompiler>& Registry() {
+  static std::map<std::string, TransitionCompiler> registry;
+  return registry;
+}
+
+// Definitions come from a user-edited file and the JSON library aborts on
+// type errors instead of throwing, so every field is checked before use.
+int IntField(const nlohmann::json& def, const char* key, int fallback) {
+  auto it = def.find(key);
+  if (it == def.end() || !it->is_number()) return fallback;
+  const double value = it->get<double>();
+  if (!(value >= INT_MIN && value <= INT_MAX)) {
+    std::cerr << "Invalid " << key << " in transition: " << it->dump() << std::endl;
+    return fallback;
+  }
+  return static_cast<int>(value);
+}
+
+std::string StringField(const nlohmann::json& def, const char* key,
+                        const std::string& fallback) {
+  auto it = def.find(key);
+  if (it == def.end() || !it->is_string()) return fallback;
+  return it->get<std::string>();
+}
+
+bool BoolField(const nlohmann::json& def, const char* key, bool fallback) {
+  auto it = def.find(key);
+  if (it == def.end() || !it->is_boolean()) return fallback;
+  return it->get<bool>();
+}
+
+int HueSteps(int degrees) { return degrees * kHueSteps / 360; }
+
+// Reads the fields every transition has. "frames" sets the cycle length,
+// or "duration_ms" does in wall time.
+void ReadCommon(const nlohmann::json& def, Transition* t) {
+  t->name = StringField(def, "name", StringField(def, "type", "transition"));
+  const int frame_ms = std::clamp(IntField(def, "frame_ms", 16), 1, kMaxFrameMs);
+  t->frame_time = std::chrono::milliseconds(frame_ms);
+  int frames = IntField(def, "frames", 0);
+  if (frames <= 0) {
+    frames = std::clamp(IntField(def, "duration_ms", 1000), 0, kMaxDurationMs) / frame_ms;
+  }
+  t->frames_per_cycle = std::clamp(frames, 2, kMaxFrames);
+  t->min_cycles = std::clamp(IntField(def, "min_cycles", 1), 1, kMaxMinCycles);
+}
+
+// A band of light sweeping over a per-pixel key: the position along a wipe,
+// the distance from the centre for a pulse, or a random rank for a
+// dissolve. Each frame of the cycle has a precomputed front; pixels whose
+// key lies within |width| behind it are lit, fading with the distance.
+// Colour comes from a hue ramp indexed per pixel. As a blend, the band is
+// the edge between the outgoing frame, ahead of it, and the incoming one.
+class BandTransition : public Transition {
+ public:
+  void Begin() override {
+    int base = hue_ >= 0 ? hue_ : rand() % 360;
+    BuildHueRamp(HueSteps(base), HueSteps(hue_span_), &ramp_);
+  }
+
+  void Draw(int frame, const TransitionEnds& ends, RgbFrame* image) override {
+    const int front = fronts_[frame % frames_per_cycle];
+    if (blends) {
+      kernel_.keyed(ends.from.pixels.data(), ends.to.pixels.data(), blend_key_.data(),
+                    image->pixels.data(), static_cast<int>(blend_key_.size()), front);
+      return;
+    }
+    const uint16_t* key = key_.data();
+    const uint8_t* hue = hue_index_.data();
+    uint8_t* out = image->pixels.data();
+    const unsigned width = width_;
+    for (size_t i = 0; i < key_.size(); ++i, out += 3) {
+      const unsigned k = front - key[i];
+      if (k > width) {
+        out[0] = out[1] = out[2] = 0;
+        continue;
+      }
+      const uint8_t* rgb = ramp_[hue[i]].data();
+      const uint32_t level = fade_[k];
+      out[0] = Div255(rgb[0] * level);
+      out[1] = Div255(rgb[1] * level);
+      out[2] = Div255(rgb[2] * level);
+    }
+  }
+
+  // Per pixel, y * width + x.
+  std::vector<uint16_t> key_;
+  std::vector<uint8_t> hue_index_;
+  // Per frame of the cycle.
+  std::vector<int> fronts_;
+  // Per step behind the front, 255 at the front down to 0.
+  std::vector<uint32_t> fade_;
+  int width_ = 1;
+  int hue_ = -1;  // degrees, or -1 for a random hue every run
+  int hue_span_ = 60;
+  HueRamp ramp_;
+  // Per byte, when blending.
+  std::vector<uint16_t> blend_key_;
+  const BlendKernel& kernel_ = BestBlendKernel();
+
+  void ReadBand(const nlohmann::json& def, int default_width) {
+    width_ = std::clamp(IntField(def, "fade", default_width), 1, UINT16_MAX);
+    hue_ = StringField(def, "hue", "") == "random" ? -1 : IntField(def, "hue", -1);
+    hue_span_ = IntField(def, "hue_span", 60);
+    fade_.resize(width_ + 1);
+    for (int k = 0; k <= width_; ++k) {
+      fade_[k] = (width_ - k) * 255 / width_;
+    }
+  }
+
+  // Fronts that move linearly from before the first key until the band has
+  // left the last one.
+  void LinearFronts(int max_key) {
+    fronts_.resize(frames_per_cycle);
+    const int span = max_key + width_ + 1;
+    for (int f = 0; f < frames_per_cycle; ++f) {
+      fronts_[f] = f * span / (frames_per_cycle - 1);
+    }
+  }
+
+  // Switches to blending. Keys are scaled so the band is 255 steps wide,
+  // the blend kernel's ramp, and repeated for the three bytes of a pixel.
+  // The fronts run from all outgoing to all incoming over one cycle.
+  void MakeBlend(int max_key) {
+    blends = true;
+    min_cycles = 1;
+    const int width = std::max(width_, (max_key * 255 + 65279) / 65280);
+    blend_key_.resize(key_.size() * 3);
+    for (size_t i = 0; i < key_.size(); ++i) {
+      const uint16_t key = key_[i] * 255 / width;
+      blend_key_[i * 3] = blend_key_[i * 3 + 1] = blend_key_[i * 3 + 2] = key;
+    }
+    key_.clear();
+    hue_index_.clear();
+    fronts_.resize(frames_per_cycle);
+    const int span = max_key * 255 / width + 255;
+    for (int f = 0; f < frames_per_cycle; ++f) {
+      fronts_[f] = f * span / (frames_per_cycle - 1);
+    }
+  }
+};
+
+std::unique_ptr<Transition> CompilePulse(const nlohmann::json& def, int width, int height) {
+  auto t = std::make_unique<BandTransition>();
+  ReadCommon(def, t.get());
+  t->ReadBand(def, 6);
+
+  PolarMap polar;
+  polar.Resize(width, height);
+  const size_t count = static_cast<size_t>(width) * height;
+  t->key_.assign(polar.distance(), polar.distance() + count);
+  t->hue_index_.assign(polar.angle(), polar.angle() + count);
+
+  // The ring grows out and falls back once per cycle.
+  const int max_radius = std::max(width / 2, height / 2);
+  t->fronts_.resize(t->frames_per_cycle);
+  for (int f = 0; f < t->frames_per_cycle; ++f) {
+    float progress = static_cast<float>(f) / (t->frames_per_cycle - 1);
+    t->fronts_[f] = static_cast<int>(sinf(progress * M_PI) * max_radius);
+  }
+  return t;
+}
+
+std::unique_ptr<Transition> CompileWipe(const nlohmann::json& def, int width, int height) {
+  auto t = std::make_unique<BandTransition>();
+  ReadCommon(def, t.get());
+  t->ReadBand(def, std::max(width, height) / 4);
+
+  const std::string direction = StringField(def, "direction", "right");
+  PolarMap polar;
+  if (direction == "out") polar.Resize(width, height);
+  const size_t count = static_cast<size_t>(width) * height;
+  t->key_.resize(count);
+  int max_key = 0;
+  size_t i = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x, ++i) {
+      int key;
+      if (direction == "left") {
+        key = width - 1 - x;
+      } else if (direction == "down") {
+        key = y;
+      } else if (direction == "up") {
+        key = height - 1 - y;
+      } else if (direction == "diagonal") {
+        key = x + y;
+      } else if (direction == "out") {
+        key = polar.distance()[i];
+      } else {
+        key = x;
+      }
+      t->key_[i] = key;
+      max_key = std::max(max_key, key);
+    }
+  }
+  // The hue runs along the direction of travel.
+  t->hue_index_.resize(count);
+  for (i = 0; i < count; ++i) {
+    t->hue_index_[i] = t->key_[i] * 255 / std::max(max_key, 1);
+  }
+  if (BoolField(def, "blend", false)) {
+    t->MakeBlend(max_key);
+  } else {
+    t->LinearFronts(max_key);
+  }
+  return t;
+}
+
+std::unique_ptr<Transition> CompileDissolve(const nlohmann::json& def, int width, int height) {
+  auto t = std::make_unique<BandTransition>();
+  ReadCommon(def, t.get());
+
+  // Each pixel gets a random rank, spread over the 16-bit key range on
+  // large panels. "fade" is given as a share of the pixels, in percent.
+  const size_t count = static_cast<size_t>(width) * height;
+  const int max_key = static_cast<int>(std::min<size_t>(count - 1, UINT16_MAX));
+  nlohmann::json band = def;
+  band["fade"] = std::max(std::clamp(IntField(def, "fade", 20), 0, 100) * max_key / 100, 1);
+  t->ReadBand(band, 1);
+
+  std::vector<uint32_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 rng(IntField(def, "seed", 1));
+  std::shuffle(order.begin(), order.end(), rng);
+  t->key_.resize(count);
+  t->hue_index_.resize(count);
+  for (size_t rank = 0; rank < count; ++rank) {
+    const int key = static_cast<int>(rank * max_key / std::max<size_t>(count - 1, 1));
+    t->key_[order[rank]] = key;
+    t->hue_index_[order[rank]] = key * 255 / std::max(max_key, 1);
+  }
+  if (BoolField(def, "blend", false)) {
+    t->MakeBlend(max_key);
+  } else {
+    t->LinearFronts(max_key);
+  }
+  return t;
+}
+
+// Dots circling the centre, speeding up and slowing down over each cycle,
+// drawn as particles. Angles are 32-bit fractions of a turn, so they wrap
+// for free. How far the dots have turned by every frame of a cycle is summed
+// up at compile time, at the slowest dot's speed; each dot scales that by
+// its own speed in Q16.
+class OrbitTransition : public Transition {
+ public:
+  void Begin() override { base_hue_ = hue_ >= 0 ? hue_ : rand() % 360; }
+
+  void Draw(int frame, const TransitionEnds&, RgbFrame* image) override {
+    const uint32_t cycle = frame / frames_per_cycle;
+    const int f = frame % frames_per_cycle;
+    const uint64_t turned = turn_[f];
+    const int hue = base_hue_ + f * 2;
+    for (size_t i = 0; i < dots_.size(); ++i) {
+      const uint32_t angle = start_[i] + cycle * cycle_turn_[i] +
+                             static_cast<uint32_t>(turned * speed_[i] >> 16);
+      dots_.x[i] = cx_ + (FixedCos(angle) * radius_[i] >> (14 - kFixedShift));
+      dots_.y[i] = cy_ + (FixedSin(angle) * radius_[i] >> (14 - kFixedShift));
+      dots_.hue[i] = (hue + i * 30) % 360;
+    }
+    image->Clear();
+    dots_.Render(sheet_, image);
+  }
+
+  int32_t cx_ = 0;  // fixed point
+  int32_t cy_ = 0;
+  int hue_ = -1;
+  int base_hue_ = 0;
+  SpriteSheet sheet_;  // one stamp per degree of hue
+  ParticleField dots_;
+  // Per dot.
+  std::vector<int32_t> radius_;
+  std::vector<uint32_t> start_;
+  std::vector<uint32_t> speed_;
+  std::vector<uint32_t> cycle_turn_;  // over a whole cycle
+  // Per frame, since the cycle began, at the base speed.
+  std::vector<uint64_t> turn_;
+};
+
+std::unique_ptr<Transition> CompileOrbit(const nlohmann::json& def, int width, int height) {
+  auto t = std::make_unique<OrbitTransition>();
+  ReadCommon(def, t.get());
+  const int dots = std::clamp(IntField(def, "dots", 4), 1, 1024);
+  const int rings = std::clamp(IntField(def, "rings", 1), 1, dots);
+  const int radius = IntField(def, "radius", std::min(width / 2, height / 2) - 1);
+  // Each dot is this much faster than the one before, in percent.
+  const int spread = std::clamp(IntField(def, "spread", 5), 0, 100);
+  t->cx_ = (width / 2) << kFixedShift;
+  t->cy_ = (height / 2) << kFixedShift;
+  t->hue_ = StringField(def, "hue", "") == "random" ? -1 : IntField(def, "hue", -1);
+  t->sheet_.BuildDot(std::clamp(IntField(def, "size", 1), 0, 8), 360);
+  t->dots_.Resize(dots);
+
+  const double kTurn = 4294967296.0 / (2 * M_PI);  // radians to 2^32ths
+  t->turn_.resize(t->frames_per_cycle);
+  double turned = 0;
+  for (int f = 0; f < t->frames_per_cycle; ++f) {
+    double progress = static_cast<double>(f) / t->frames_per_cycle;
+    turned += (1.0 - cos(progress * M_PI)) * 0.15 + 0.015;  // slow mid-cycle
+    t->turn_[f] = static_cast<uint64_t>(turned * kTurn);
+  }
+
+  t->radius_.resize(dots);
+  t->start_.resize(dots);
+  t->speed_.resize(dots);
+  t->cycle_turn_.resize(dots);
+  for (int i = 0; i < dots; ++i) {
+    t->radius_[i] = radius * (rings - i % rings) / rings;
+    t->start_[i] = static_cast<uint32_t>(static_cast<double>(i) / dots * 4294967296.0);
+    t->speed_[i] = 65536 + static_cast<int64_t>(i) * spread * 65536 / 100;
+    t->cycle_turn_[i] = static_cast<uint32_t>(t->turn_.back() * t->speed_[i] >> 16);
+  }
+  return t;
+}
+
+// The outgoing frame fading evenly into the incoming one.
+class CrossfadeTransition : public Transition {
+ public:
+  void Draw(int frame, const TransitionEnds& ends, RgbFrame* image) override {
+    const int weight = frame % frames_per_cycle * 255 / (frames_per_cycle - 1);
+    kernel_.crossfade(ends.from.pixels.data(), ends.to.pixels.data(), image->pixels.data(),
+                      static_cast<int>(image->pixels.size()), weight);
+  }
+
+  const BlendKernel& kernel_ = BestBlendKernel();
+};
+
+std::unique_ptr<Transition> CompileCrossfade(const nlohmann::json& def, int, int) {
+  auto t = std::make_unique<CrossfadeTransition>();
+  ReadCommon(def, t.get());
+  t->blends = true;
+  t->min_cycles = 1;
+  return t;
+}
+
+// Copies frame |index| of |frames| into |image|, cropped or padded with
+// black to the canvas size it already has.
+void CopyToCanvasSize(const FrameCache& frames, size_t index, RgbFrame* image) {
+  image->Clear();
+  if (index >= frames.frame_count()) return;
+  const int width = std::min(frames.width, image->width);
+  const int height = std::min(frames.height, image->height);
+  const uint8_t* src = frames.frame(index);
+  for (int y = 0; y < height; ++y) {
+    std::copy_n(src + static_cast<size_t>(y) * frames.width * 3, width * 3, image->row(y));
+  }
+}
+
+void RegisterBuiltins() {
+  static bool registered = false;
+  if (registered) return;
+  registered = true;
+  RegisterTransitionType("pulse", &CompilePulse);
+  RegisterTransitionType("wipe", &CompileWipe);
+  RegisterTransitionType("dissolve", &CompileDissolve);
+  RegisterTransitionType("orbit", &CompileOrbit);
+  RegisterTransitionType("crossfade", &CompileCrossfade);
+}
+
+}  // namespace
+
+void RegisterTransitionType(const std::string& type, TransitionCompiler compile) {
+  Registry()[type] = compile;
+}
+
+void TransitionEngine::Load(const std::string& path, int width, int height) {
+  std::ifstream file(path);
+  std::stringstream text;
+  if (file.is_open()) text << file.rdbuf();
+  LoadText(text.str(), path, width, height);
+}
+
+void TransitionEngine::LoadText(const std::string& text, const std::string& source,
+                                int width, int height) {
+  RegisterBuiltins();
+  srand(time(nullptr));
+  transitions_.clear();
+  next_cover_ = next_blend_ = 0;
+  have_ends_ = false;
+  image_.Resize(width, height);
+  ends_.from.Resize(width, height);
+  ends_.to.Resize(width, height);
+
+  if (!text.empty()) Compile(text, source, width, height);
+  if (transitions_.empty()) {
+    Compile(kBuiltinTransitions, "built-in transitions", width, height);
+  } else if (std::all_of(transitions_.begin(), transitions_.end(),
+                         [](const auto& t) { return t->blends; })) {
+    // Blends need the next app decoded, so something must cover the decodes
+    // that are not: the built-in OrbitDots.
+    std::cerr << "⚠️ " << source << " has no transition that covers a decode, adding OrbitDots"
+              << std::endl;
+    const nlohmann::json builtins = nlohmann::json::parse(kBuiltinTransitions, nullptr, false);
+    transitions_.push_back(CompileOrbit(builtins[0], width, height));
+  }
+  std::cout << "✨ " << transitions_.size() << " transitions compiled for " << width
+            << "x" << height << std::endl;
+}
+
+void TransitionEngine::Compile(const std::string& text, const std::string& source,
+                               int width, int height) {
+  nlohmann::json defs = nlohmann::json::parse(text, nullptr, false);
+  if (defs.is_discarded() || !defs.is_array()) {
+    std::cerr << "⚠️ " << source << " is not a JSON array of transitions" << std::endl;
+    return;
+  }
+  for (const nlohmann::json& def : defs) {
+    if (!def.is_object()) continue;
+    const std::string type = StringField(def, "type", "");
+    auto it = Registry().find(type);
+    if (it == Registry().end()) {
+      std::cerr << "⚠️ Unknown transition type '" << type << "' in " << source << std::endl;
+      continue;
+    }
+    if (auto t = it->second(def, width, height)) {
+      transitions_.push_back(std::move(t));
+    }
+  }
+}
+
+void TransitionEngine::SetEnds(const FrameCache& from, size_t from_index,
+                               const FrameCache& to) {
+  CopyToCanvasSize(from, from_index, &ends_.from);
+  CopyToCanvasSize(to, 0, &ends_.to);
+  have_ends_ = true;
+}
+
+Transition* TransitionEngine::Next(bool blends) {
+  size_t& next = blends ? next_blend_ : next_cover_;
+  for (size_t n = 0; n < transitions_.size(); ++n) {
+    Transition* t = transitions_[next++ % transitions_.size()].get();
+    if (t->blends == blends) return t;
+  }
+  return nullptr;
+}
+
+PacingStats TransitionEngine::Play(DisplaySink* display, const ReadyFn& ready) {
+  Transition* next = have_ends_ ? Next(true) : nullptr;
+  if (next == nullptr) next = Next(false);
+  have_ends_ = false;
+  if (next == nullptr) return PacingStats();
+  Transition& t = *next;
+  std::cout << "✨ Transition: " << t.name << std::endl;
+
+  t.Begin();
+  FramePacer pacer(LatePolicy::kDropFrames, time_);
+  for (int frame = 0;; ++frame) {
+    if (frame % t.frames_per_cycle == 0 && frame >= t.min_cycles * t.frames_per_cycle &&
+        (t.blends || ready())) {
+      break;
+    }
+    // Every frame is drawn from its number alone, so late ones are skipped.
+    if (pacer.ShouldDrop(t.frame_time)) continue;
+    t.Draw(frame, ends_, &image_);
+    BlitFrame(display, image_);
+    display->Swap();
+    pacer.Wait(t.frame_time);
+  }
+  pacer.Report(t.name.c_str());
+  return pacer.stats();
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blit.h"
+#include "display.h"
+#include "frame_cache.h"
+#include "frame_pacer.h"
+#include "json.hpp"
+#include "time_source.h"
+
+// Tells a transition whether the app it leads into has been decoded.
+using ReadyFn = std::function<bool()>;
+
+// The frames either side of a handoff, copied to the canvas size: the last
+// frame the outgoing app showed and the first of the incoming one.
+struct TransitionEnds {
+  RgbFrame from;
+  RgbFrame to;
+};
+
+// One transition compiled for a canvas size. Everything that can be worked
+// out ahead of time (per-pixel timing and masks, colour ramps, paths) is
+// built when it is compiled, so drawing a frame is table lookups.
+class Transition {
+ public:
+  virtual ~Transition() = default;
+
+  // Called before every run, e.g. to pick a fresh hue.
+  virtual void Begin() {}
+  // Draws frame |frame| of the run, counted across cycles, into |image|.
+  // Only blending transitions look at |ends|.
+  virtual void Draw(int frame, const TransitionEnds& ends, RgbFrame* image) = 0;
+
+  std::string name;
+  // Blends |ends| instead of drawing over black, so it can only play once
+  // the incoming app is decoded. Plays a single cycle.
+  bool blends = false;
+  std::chrono::milliseconds frame_time{16};
+  int frames_per_cycle = 60;
+  // Cycles always played before the transition may end.
+  int min_cycles = 1;
+};
+
+// Builds a Transition from its JSON definition for a |width| x |height|
+// canvas, or logs why not and returns nullptr.
+using TransitionCompiler = std::unique_ptr<Transition> (*)(
+    const nlohmann::json& def, int width, int height);
+
+// Makes |type| usable in transition definitions. wipe, dissolve, pulse,
+// orbit and crossfade are built in.
+void RegisterTransitionType(const std::string& type, TransitionCompiler compile);
+
+// Plays transitions defined in a JSON file, one after another. The file is
+// an array of definitions:
+//
+//   [{"name": "Sweep", "type": "wipe", "direction": "right",
+//     "frame_ms": 16, "frames": 40, "min_cycles": 1, "hue": 200}]
+//
+// Every transition is drawn by the same paced loop. It plays in cycles of
+// |frames| and ends at the first cycle boundary, after |min_cycles|, at which
+// the next app is ready. Crossfades, and wipes and dissolves with
+// "blend": true, hand the outgoing app over to the incoming one instead and
+// take turns among themselves whenever SetEnds was called; the rest cover
+// decodes that are still running.
+class TransitionEngine {
+ public:
+  // Paces every transition on |time|.
+  explicit TransitionEngine(TimeSource* time = SystemTime()) : time_(time) {}
+
+  // Compiles the definitions in |path| for a |width| x |height| canvas. Falls
+  // back to the built-in OrbitDots, Pulse and Crossfade if the file is
+  // missing or defines nothing usable, and adds OrbitDots if it only defines
+  // transitions that blend.
+  void Load(const std::string& path, int width, int height);
+  // As Load, from the definitions in |text|; |source| names them in logs.
+  void LoadText(const std::string& text, const std::string& source, int width,
+                int height);
+
+  // Everything compiled, in the order the transitions take turns.
+  const std::vector<std::unique_ptr<Transition>>& transitions() const {
+    return transitions_;
+  }
+
+  // Gives the next Play the outgoing app's frame |from_index| and the
+  // incoming app's first frame to blend between.
+  void SetEnds(const FrameCache& from, size_t from_index, const FrameCache& to);
+
+  // Plays the next transition in turn, a blending one if SetEnds was called
+  // since the last run, onto |display|. Returns how its frames were paced.
+  PacingStats Play(DisplaySink* display, const ReadyFn& ready);
+
+ private:
+  void Compile(const std::string& text, const std::string& source, int width,
+               int height);
+
+  // Picks the next transition in turn among those that do or do not blend.
+  Transition* Next(bool blends);
+
+  TimeSource* const time_;
+  std::vector<std::unique_ptr<Transition>> transitions_;
+  size_t next_cover_ = 0;
+  size_t next_blend_ = 0;
+  TransitionEnds ends_;
+  bool have_ends_ = false;
+  RgbFrame image_;
+};